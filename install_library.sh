@@ -0,0 +1,37 @@
+#!/bin/sh
+# Installs "working coordination" as the LoRaCoordination Arduino library, which the sketches
+# at the repository root include. The folder is linked rather than copied, so the sketches
+# always build against the headers in this checkout. Every coordination header exists only in
+# the library's src folder; the script refuses to install while a copy of one sits at the
+# repository root.
+#
+# Usage: ./install_library.sh [libraries folder]
+# The libraries folder defaults to $ARDUINO_LIBRARIES, then ~/Arduino/libraries.
+set -e
+
+repo=$(cd "$(dirname "$0")" && pwd)
+libraries=${1:-${ARDUINO_LIBRARIES:-$HOME/Arduino/libraries}}
+target="$libraries/LoRaCoordination"
+
+# A header next to the sketches would shadow the library's copy of it for quoted includes
+shadowed=0
+for header in "$repo"/*.h; do
+    [ -e "$header" ] || continue
+    name=$(basename "$header")
+    if [ -e "$repo/working coordination/src/$name" ]; then
+        echo "$name at the repository root shadows the library's copy, remove one of them." >&2
+        shadowed=1
+    fi
+done
+if [ "$shadowed" -ne 0 ]; then
+    exit 1
+fi
+
+if [ -e "$target" ] && [ ! -L "$target" ]; then
+    echo "$target exists and is not a link, remove it first." >&2
+    exit 1
+fi
+
+mkdir -p "$libraries"
+ln -sfn "$repo/working coordination" "$target"
+echo "Linked $target to $repo/working coordination."
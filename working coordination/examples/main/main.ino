@@ -0,0 +1,399 @@
+/**
+ * @file main.ino
+ * @brief This file contains the implementation of the Heltec LoRa device functions, handling both the host and client roles, with deep sleep functionality.
+ */
+
+#include <heltec_unofficial.h> // Includes Heltec library for display and LoRa functionalities
+#include <RadioLib.h>          // Includes RadioLib library for LoRa communication
+#include "Timer.h"             // Includes the Timer class header
+#include "WakeUpCoordination.h" // Includes WakeUpCoordination header
+#include "CoordinationState.h" // Includes the CoordinationState class header
+#include "RadioConfig.h"       // Includes the RadioConfig structure header
+#include "ChannelPlan.h"       // Includes the ChannelPlan structure header
+#include "DisplayQueue.h"      // Includes the queue between the radio and display tasks
+#include "StatusScreen.h"      // Includes the line cache that keeps unchanged text off the I2C bus
+#include "PacketPool.h"        // Includes the pool of received frames
+#include "FrameLog.h"          // Includes the flash log of received frames
+#include "JobScheduler.h"      // Includes the scheduler that batches periodic jobs into shared wakes
+#include "PowerPolicy.h"       // Includes the battery levels that stretch the cycle
+#include "esp_sleep.h"         // Includes ESP sleep functions
+
+// Radio configuration
+#define FREQUENCY 915.0        // Frequency of channel 0 for LoRa communication
+#define CHANNEL_SPACING 0.4    // Spacing between channels in MHz
+#define HOP_CHANNELS 8         // Channels in each cell's sub-band (1 to stay on one channel, at most 15)
+#define CELL_SUB_BAND 0        // Sub-band of this cell, 0 to 3 fit below 928 MHz; neighbouring cells need different ones
+#define DUTY_CYCLE 0.0         // Share of any hour a node may transmit in its sub-band, e.g. 0.01 in the EU 868 band; 0 for no limit
+#define BANDWIDTH 250.0        // Bandwidth for LoRa communication
+#define SPREADING_FACTOR 9     // Spreading factor for LoRa communication
+#define TRANSMIT_POWER 20      // Maximum transmit power for LoRa
+
+#define IS_HOST false          // Define the role of the device (true for host, false for client)
+#define MESSAGE_INTERVAL 10    // Seconds between cycles at full battery, PowerPolicy stretches it while batteries drain
+#define WAIT_TIME 5            // Wait time the host announces in the beacon in seconds
+#define GATEWAY_MODE false     // True for a host to log every received frame to flash and replay the log on a normal boot
+#define HOST_LIGHT_SLEEP true  // True for a host to light-sleep between beacons, waking on DIO1 or a timer
+#define ACK_METRICS true       // True for a client to append its link summary to each ACK
+#define LED_BRIGHTNESS 20      // Set LED brightness to 20%
+#define STATS_DISPLAY_INTERVAL 30 // Timer wakeups between full boots that show the stats (0 to never show)
+#define TRACE_DUMP_INTERVAL 100   // Cycles between cycle trace and metrics dumps to Serial before sleeping (0 to never dump)
+#define METRICS_COMMAND 'm'       // Serial command that prints the metrics snapshot before the next sleep
+#define BATTERY_REPORT_INTERVAL 600 // Seconds between battery reports to Serial
+// Seconds a battery report may wait for a wake the coordination needs anyway: the longest cycle, at the deepest power-saving level
+#define BATTERY_REPORT_TOLERANCE PowerPolicy::intervalFor(MESSAGE_INTERVAL, PowerPolicy::LEVEL_COUNT - 1)
+
+// Jobs of the job scheduler
+enum JobId {
+  JOB_COORDINATE,    // Coordination cycle, due at the wake the WakeScheduler computed
+  JOB_BATTERY_REPORT // Battery level report
+};
+
+TaskHandle_t taskHandle;       // Task handle for the radio task
+DisplayQueue displayQueue;     // Display events from the radio task to loop()
+StatusScreen screen(display);  // Text on the OLED, only drawn by setup() and loop()
+RTC_DATA_ATTR uint32_t deepSleepWakeupCount = 0;  // Counter for deep sleep wakeups
+RTC_DATA_ATTR float lastBatteryPercent = 0;       // Battery level measured on the last wake
+RTC_DATA_ATTR uint32_t lastAwakeMs = 0;           // Time the last cycle stayed awake in milliseconds
+bool headless = false;                            // True if this boot skipped the display
+RTC_DATA_ATTR CoordinationState state;            // Schedule, drift, clients and radio settings, kept across deep sleep
+RTC_DATA_ATTR JobScheduler jobs;                  // Deadlines of the coordination cycle and the periodic jobs
+
+// Radio settings applied after a normal boot
+const RadioConfig DEFAULT_RADIO_CONFIG = {
+  FREQUENCY, BANDWIDTH, SPREADING_FACTOR, 7, RADIOLIB_SX126X_SYNC_WORD_PRIVATE, TRANSMIT_POWER, 8, 1.6, false
+};
+
+// Channels the cell hops over, the radio starts on the home channel of the sub-band
+const ChannelPlan CHANNEL_PLAN = {
+  FREQUENCY, CHANNEL_SPACING, HOP_CHANNELS, CELL_SUB_BAND, DUTY_CYCLE
+};
+
+PacketPool packetPool;          // Received frames, shared by handle instead of copied
+WakeUpCoordination coordinator(packetPool); // Declare an instance of WakeUpCoordination
+FrameLog frameLog;              // Received frames kept in the framelog partition (see partitions.csv)
+
+/**
+ * @brief Initialize the LoRa radio with the stored settings
+ *
+ * A radio that went to sleep with unchanged settings is warm-started; otherwise,
+ * or if the warm start fails, it gets the full reset and calibration of begin().
+ */
+void initializeRadio() {
+  int64_t initStartUs = esp_timer_get_time();
+  int radioState = RADIOLIB_ERR_UNKNOWN;
+  if (state.isRadioRetained()) {
+    radioState = state.radio.warmStart(radio);
+    if (radioState != RADIOLIB_ERR_NONE) {
+      Serial.println("Radio warm start failed, reinitializing.");
+    }
+  }
+  if (radioState != RADIOLIB_ERR_NONE) {
+    radioState = state.radio.begin(radio);
+  }
+  state.setRadioRetained(false); // Valid again only once the radio is put to warm sleep
+  state.trace.recordSince(CycleTrace::PHASE_RADIO_INIT, initStartUs);
+  if (radioState == RADIOLIB_ERR_NONE) {
+    Serial.println("Radio initialization successful!");
+  } else {
+    Serial.println("Radio initialization failed!");
+    while (1); // Halt if radio initialization fails
+  }
+}
+
+/**
+ * @brief Initialize Heltec display and LoRa
+ */
+void initializeHeltec() {
+  heltec_setup(); // Initialize Heltec display
+  Serial.begin(115200); // Initialize serial communication at 115200 baud rate
+
+  initializeRadio();
+
+  // Display battery percentage, wakeup count and the awake time recorded by headless wakes
+  lastBatteryPercent = heltec_battery_percent();
+  char line[StatusScreen::LINE_LENGTH];
+  snprintf(line, sizeof(line), "Battery: %.1f%%", lastBatteryPercent);
+  screen.setLine(0, line);
+  snprintf(line, sizeof(line), "Wakeups: %lu", (unsigned long)deepSleepWakeupCount);
+  screen.setLine(1, line);
+  snprintf(line, sizeof(line), "Last awake: %lu ms", (unsigned long)lastAwakeMs);
+  screen.setLine(2, line);
+  screen.flush();
+  delay(300); // Display for 0.3 seconds
+
+  // Clear the display after showing initial information
+  screen.clear();
+  screen.flush();
+}
+
+/**
+ * @brief Initialize only the LoRa radio, leaving the display powered off
+ *
+ * Mirrors the radio part of heltec_setup() and records the stats in RTC memory
+ * instead of drawing them, so a timer wake is ready to listen as early as possible.
+ */
+void initializeHeadless() {
+#ifndef ARDUINO_heltec_wifi_32_lora_V3
+  hspi->begin(SCK, MISO, MOSI, SS); // The radio SPI bus is otherwise started by heltec_setup()
+#endif
+  initializeRadio();
+  lastBatteryPercent = heltec_battery_percent();
+}
+
+/**
+ * @brief Setup function to initialize the device
+ */
+void setup() {
+  int64_t setupStartUs = esp_timer_get_time(); // End of the boot phase
+  Serial.begin(115200); // Initialize serial communication at 115200 baud rate
+  esp_sleep_wakeup_cause_t wakeup_reason = esp_sleep_get_wakeup_cause(); // Detect the wake-up reason
+
+  // Handle wake-up reasons
+  if (wakeup_reason == ESP_SLEEP_WAKEUP_TIMER) {
+    Serial.println("Waking up from deep sleep.");
+    deepSleepWakeupCount++; // Increment wakeup count on deep sleep wakeup
+  } else {
+    Serial.println("Normal boot.");
+    deepSleepWakeupCount = 0; // Reset wakeup count on normal boot
+  }
+
+  if (wakeup_reason != ESP_SLEEP_WAKEUP_TIMER || !state.isValid()) {
+    resetState(); // Only a normal boot or lost RTC memory forces a full re-sync
+    Serial.println("Reinitialized coordination state.");
+  } else if (!jobs.isDue(JOB_COORDINATE, WakeScheduler::nowUs())) {
+    runJobsAndSleep(); // Woken for a periodic job only, the radio keeps sleeping
+  }
+  state.trace.beginCycle();
+  state.trace.record(CycleTrace::PHASE_BOOT, 0, setupStartUs);
+
+  // Timer wakes boot headless, except every STATS_DISPLAY_INTERVAL wakeups to show the stats
+  headless = wakeup_reason == ESP_SLEEP_WAKEUP_TIMER &&
+             (STATS_DISPLAY_INTERVAL == 0 || deepSleepWakeupCount % STATS_DISPLAY_INTERVAL != 0);
+  if (headless) {
+    initializeHeadless(); // Bring up only the radio
+  } else {
+    initializeHeltec(); // Initialize Heltec display and LoRa
+  }
+  coordinator.setNodeId(WakeUpCoordination::defaultNodeId()); // Node ID from the MAC address
+  coordinator.setLightSleep(IS_HOST && HOST_LIGHT_SLEEP);
+  coordinator.setAckMetrics(!IS_HOST && ACK_METRICS);
+  coordinator.setBatteryPercent(lastBatteryPercent); // Reported in ACKs, and sets the host's power-saving level
+  coordinator.setCellSchedule(MESSAGE_INTERVAL, WAIT_TIME); // Only used by a host
+  if (IS_HOST && GATEWAY_MODE) {
+    initializeGateway(wakeup_reason != ESP_SLEEP_WAKEUP_TIMER);
+  }
+
+  displayQueue.begin(); // Must exist before the radio task posts to it
+
+  // Create the radio task on core 0; loop() keeps running on core 1 and owns the display
+  xTaskCreatePinnedToCore(
+    radioTask, // Function to implement the task
+    "RadioTask", // Name of the task
+    10000, // Stack size in words
+    NULL, // Task input parameter
+    1, // Priority of the task
+    &taskHandle, // Task handle
+    0); // Core where the task should run (0 for PRO_CPU, 1 for APP_CPU)
+}
+
+/**
+ * @brief Open the frame log and start logging every received frame
+ * @param replay True to print the whole log to Serial first
+ */
+void initializeGateway(bool replay) {
+  if (!frameLog.begin()) {
+    Serial.println("Frame log partition not found, gateway logging disabled.");
+    return;
+  }
+  if (replay) {
+    uint32_t count = frameLog.replay(Serial); // Bulk dump for the backhaul, before the radio task starts
+    Serial.print("Replayed ");
+    Serial.print((unsigned long)count);
+    Serial.println(" logged frames.");
+  }
+  coordinator.setPacketFunction(logFrame);
+}
+
+/**
+ * @brief Append a received frame to the frame log, called from the radio task
+ * @param packet The received frame
+ */
+void logFrame(const PacketPool::Packet& packet) {
+  uint16_t nodeId = WakeUpCoordination::senderOf(packet.data(), packet.getLength());
+  frameLog.append(nodeId, (uint32_t)time(NULL), packet.getRssi(), packet.getSnr(), packet.data(), packet.getLength()); // Batched in RAM, dropped if the batch is full
+}
+
+/**
+ * @brief Reset the state variables
+ */
+void resetState() {
+  state.reset(DEFAULT_RADIO_CONFIG, CHANNEL_PLAN); // Forget the schedule, drift and clients
+  jobs.reset();
+  jobs.schedule(JOB_BATTERY_REPORT, WakeScheduler::nowUs() + BATTERY_REPORT_INTERVAL * 1000000LL,
+                BATTERY_REPORT_INTERVAL * 1000UL, BATTERY_REPORT_TOLERANCE * 1000UL);
+}
+
+/**
+ * @brief Run a job taken from the job scheduler
+ * @param id The job
+ */
+void runJob(uint8_t id) {
+  switch (id) {
+    case JOB_BATTERY_REPORT:
+      lastBatteryPercent = heltec_battery_percent();
+      Serial.print("Battery: ");
+      Serial.print(lastBatteryPercent, 1);
+      Serial.println("%");
+      break;
+    default:
+      break; // JOB_COORDINATE is run by the radio task
+  }
+}
+
+/**
+ * @brief Run the jobs due on a wake that needs no coordination, then sleep until the next deadline
+ *
+ * Called from setup() before the radio is touched, so the radio stays in warm sleep.
+ */
+void runJobsAndSleep() {
+  uint8_t id;
+  while ((id = jobs.takeDue(WakeScheduler::nowUs())) != JobScheduler::NO_JOB) {
+    runJob(id);
+  }
+  int64_t sleepUs = jobs.nextWakeUs() - WakeScheduler::nowUs();
+  Serial.flush();
+  startDeepSleep(sleepUs > 0 ? (uint64_t)sleepUs : 1);
+}
+
+/**
+ * @brief Power down the board and deep-sleep with a microsecond wake timer
+ *
+ * Does what heltec_deep_sleep() does, except for its radio reset: that helper takes whole
+ * seconds and cold-starts the radio, which would lose the schedule precision and the warm
+ * sleep. Floating the pins keeps them from leaking current through the sleeping peripherals.
+ * @param sleepUs Sleep duration in microseconds
+ */
+void startDeepSleep(uint64_t sleepUs) {
+  heltec_led(0);        // Turn off the LED
+  heltec_ve(false);     // Turn off external power
+  pinMode(VBAT_CTRL, INPUT);
+  pinMode(VBAT_ADC, INPUT);
+  pinMode(DIO1, INPUT);
+  pinMode(RST_LoRa, INPUT);
+  pinMode(BUSY_LoRa, INPUT);
+  pinMode(SS, INPUT);
+  pinMode(MISO, INPUT);
+  pinMode(MOSI, INPUT);
+  pinMode(SCK, INPUT);
+  pinMode(SDA_OLED, INPUT);
+  pinMode(SCL_OLED, INPUT);
+  pinMode(RST_OLED, INPUT);
+#ifdef HELTEC_POWER_BUTTON
+  esp_sleep_enable_ext0_wakeup(BUTTON, LOW); // The power button wakes the board like a power-on
+  button.waitForRelease();
+#endif
+  esp_sleep_enable_timer_wakeup(sleepUs);
+  esp_deep_sleep_start();
+}
+
+/**
+ * @brief Enter deep sleep with a microsecond wake timer
+ * @param sleepUs Sleep duration in microseconds
+ */
+void enterDeepSleep(uint64_t sleepUs) {
+  lastAwakeMs = millis(); // Awake time of this cycle, shown on the next full boot
+  state.setRadioRetained(radio.sleep(true) == RADIOLIB_ERR_NONE); // Warm sleep keeps the configuration
+  radio.clearDio1Action(); // No more notifications from the radio
+  if (!headless) {
+    displayQueue.powerOff(pdMS_TO_TICKS(200)); // The display task turns off the display
+  }
+  if (frameLog.getPending() > 0 && !frameLog.flush()) { // All flash writes and erases happen here, after the last frame
+    Serial.println("Frame log write failed.");
+  }
+  bool metricsRequested = false;
+  while (Serial.available() > 0) {
+    metricsRequested |= Serial.read() == METRICS_COMMAND;
+  }
+  if (TRACE_DUMP_INTERVAL != 0 && state.trace.getCycle() % TRACE_DUMP_INTERVAL == 0) {
+    state.trace.dump(Serial); // Blocking output, the radio is already asleep
+    metricsRequested = true;
+  }
+  if (metricsRequested) {
+    state.metrics.printSnapshot(Serial);
+  }
+  startDeepSleep(sleepUs);
+}
+
+/**
+ * @brief Main loop function, runs on core 1 and owns the display
+ *
+ * Only this task touches the OLED, so its I2C transfers never delay the radio task.
+ */
+void loop() {
+  DisplayQueue::Event event;
+  TickType_t wait = screen.isDirty() ? pdMS_TO_TICKS(screen.msUntilFlush()) : portMAX_DELAY;
+  if (!displayQueue.receive(event, wait)) {
+    screen.flush(); // Push the change the refresh interval held back
+    return;
+  }
+
+  int64_t drawStartUs = esp_timer_get_time();
+  if (!headless) {
+    switch (event.type) {
+      case DisplayQueue::EVENT_TEXT:
+        screen.setLines(event.lines, event.lineCount);
+        break;
+      case DisplayQueue::EVENT_CLEAR:
+        screen.clear();
+        break;
+      case DisplayQueue::EVENT_POWER_OFF:
+        display.displayOff();
+        break;
+    }
+    screen.flush(); // Only if a line changed, at most once per refresh interval
+    state.trace.recordSince(CycleTrace::PHASE_DISPLAY, drawStartUs);
+  }
+  DisplayQueue::acknowledge(event);
+}
+
+/**
+ * @brief Function to display messages on the OLED, called from the radio task
+ * @param line1 First line of text to display
+ * @param line2 Second line of text to display
+ */
+void displayFunction(const char* line1, const char* line2) {
+  if (headless) {
+    return; // The display was not initialized on this boot
+  }
+  displayQueue.postText(line1, line2); // Copies the lines, never blocks the radio task
+}
+
+/**
+ * @brief Radio task, runs on core 0 and owns the radio
+ * @param parameter Pointer to the task parameter (not used)
+ */
+void radioTask(void *parameter) {
+  while (true) {
+    heltec_loop(); // Loop function for Heltec tasks
+
+    uint64_t coordinationSleep = coordinator.coordinate(state, IS_HOST, radio, heltec_led, displayFunction);
+
+    // Jobs due by now share this wake; the next wake is the earliest deadline of all jobs
+    int64_t nowUs = WakeScheduler::nowUs();
+    jobs.schedule(JOB_COORDINATE, nowUs + (int64_t)coordinationSleep);
+    uint8_t id;
+    while ((id = jobs.takeDue(nowUs)) != JobScheduler::NO_JOB) {
+      runJob(id);
+    }
+    int64_t wakeUs = jobs.nextWakeUs() - WakeScheduler::nowUs();
+    uint64_t sleepDuration = wakeUs > 0 ? (uint64_t)wakeUs : 1;
+
+    Serial.print("Going to sleep for ");
+    Serial.print((unsigned long)(sleepDuration / 1000));
+    Serial.println(" ms.");
+
+    enterDeepSleep(sleepDuration); // Enter deep sleep for calculated duration
+
+    vTaskDelay(1); // Yield to other tasks
+  }
+}
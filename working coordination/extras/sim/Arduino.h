@@ -0,0 +1,234 @@
+/**
+ * @file Arduino.h
+ * @brief This file contains the native stand-in for the Arduino and ESP-IDF APIs the coordination firmware uses, backed by SimKernel.
+ *
+ * Only compiled into the simulator, which puts the sim directory first on the include path
+ * so the firmware headers pick up this file instead of the Arduino core.
+ */
+
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+#include <random>
+#include "SimKernel.h"
+
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define DEC 10
+#define HEX 16
+#define LOW 0
+#define HIGH 1
+
+typedef void* TaskHandle_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portYIELD_FROM_ISR(woken) (void)(woken)
+
+/**
+ * @struct portMUX_TYPE
+ * @brief Spinlock placeholder, the kernel never runs two nodes at once.
+ */
+struct portMUX_TYPE {
+    int owner;
+};
+#define portMUX_INITIALIZER_UNLOCKED {0}
+inline void portENTER_CRITICAL(portMUX_TYPE*) {}
+inline void portEXIT_CRITICAL(portMUX_TYPE*) {}
+
+/**
+ * @brief Random source shared by the firmware of all nodes, seeded by the simulator.
+ * @return The generator.
+ */
+inline std::mt19937& simRandom() {
+    static std::mt19937 generator(1);
+    return generator;
+}
+
+/**
+ * @brief Microseconds on the running node's clock since its last boot.
+ * @return The time in microseconds.
+ */
+inline int64_t simSinceBootUs() {
+    SimKernel& kernel = SimKernel::instance();
+    SimNode* node = kernel.self();
+    return node == NULL ? kernel.now() : kernel.readClock() - node->bootLocalUs;
+}
+
+inline int64_t esp_timer_get_time() { return simSinceBootUs(); }
+inline unsigned long millis() { return (unsigned long)(simSinceBootUs() / 1000); }
+inline unsigned long micros() { return (unsigned long)simSinceBootUs(); }
+inline void delay(unsigned long ms) { SimKernel::instance().sleepLocal((int64_t)ms * 1000); }
+
+inline long random(long low, long high) {
+    if (high <= low) {
+        return low;
+    }
+    return low + (long)(simRandom()() % (uint32_t)(high - low));
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return SimKernel::instance().self(); }
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    int64_t timeoutUs = ticks == portMAX_DELAY ? -1 : (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+    return SimKernel::instance().take(clear != pdFALSE, timeoutUs);
+}
+
+inline void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken) {
+    SimKernel::instance().notify(task);
+    if (higherPriorityTaskWoken != NULL) {
+        *higherPriorityTaskWoken = pdTRUE;
+    }
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    SimKernel::instance().notify(task);
+    return pdTRUE;
+}
+
+typedef int gpio_num_t;
+typedef enum { GPIO_INTR_LOW_LEVEL = 4, GPIO_INTR_HIGH_LEVEL = 5 } gpio_int_type_t;
+inline int gpio_wakeup_enable(gpio_num_t, gpio_int_type_t) { return 0; }
+inline int gpio_wakeup_disable(gpio_num_t) { return 0; }
+
+/**
+ * @brief Reads a pin of the running node; every pin reads as the radio's DIO1.
+ * @return HIGH or LOW.
+ */
+inline int digitalRead(uint32_t) {
+    SimNode* node = SimKernel::instance().self();
+    return node != NULL && node->irqLevel ? HIGH : LOW;
+}
+
+/**
+ * @brief Wall clock of the running node, which keeps counting through deep sleep like the ESP32 RTC.
+ */
+inline int simGettimeofday(struct timeval* tv) {
+    SimKernel& kernel = SimKernel::instance();
+    int64_t us = kernel.self() == NULL ? kernel.now() : kernel.readClock();
+    tv->tv_sec = (time_t)(us / 1000000);
+    tv->tv_usec = (suseconds_t)(us % 1000000);
+    return 0;
+}
+
+inline time_t simTime(time_t* out) {
+    struct timeval tv;
+    simGettimeofday(&tv);
+    if (out != NULL) {
+        *out = tv.tv_sec;
+    }
+    return tv.tv_sec;
+}
+
+/**
+ * @class Print
+ * @brief Text output collected per node, one line at a time.
+ *
+ * Complete lines are printed with the virtual time and node index when the simulator runs verbose.
+ */
+class Print {
+public:
+    static bool& verbose() {
+        static bool enabled = false;
+        return enabled;
+    }
+
+    size_t print(const char* text) { return append(text); }
+    size_t print(char value) { char text[2] = {value, '\0'}; return append(text); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(long value, int base = DEC) {
+        if (base != DEC) {
+            return print((unsigned long)value, base);
+        }
+        char text[24];
+        snprintf(text, sizeof(text), "%ld", value);
+        return append(text);
+    }
+    size_t print(unsigned long value, int base = DEC) {
+        char text[24];
+        snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", value);
+        return append(text);
+    }
+    size_t print(double value, int digits = 2) {
+        char text[32];
+        snprintf(text, sizeof(text), "%.*f", digits, value);
+        return append(text);
+    }
+
+    size_t println() { return append("\n"); }
+    template <typename T>
+    size_t println(T value) { return print(value) + println(); }
+    template <typename T>
+    size_t println(T value, int format) { return print(value, format) + println(); }
+
+private:
+    size_t append(const char* text) {
+        SimKernel& kernel = SimKernel::instance();
+        SimNode* node = kernel.self();
+        if (node == NULL) {
+            fputs(text, stdout);
+            return strlen(text);
+        }
+        for (const char* c = text; *c != '\0'; ++c) {
+            if (*c != '\n') {
+                node->line += *c;
+                continue;
+            }
+            if (verbose()) {
+                printf("%10.3f s node %2d: %s\n", (double)kernel.now() / 1e6, node->index, node->line.c_str());
+            }
+            node->line.clear();
+        }
+        return strlen(text);
+    }
+};
+
+/**
+ * @class HardwareSerial
+ * @brief Serial port of a node.
+ */
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    void flush() {}
+};
+
+/**
+ * @struct EspClass
+ * @brief Chip information of the running node.
+ */
+struct EspClass {
+    uint64_t getEfuseMac() {
+        SimNode* node = SimKernel::instance().self();
+        return node == NULL ? 0 : node->mac;
+    }
+};
+
+inline HardwareSerial& simSerial() {
+    static HardwareSerial serial;
+    return serial;
+}
+
+static EspClass ESP;
+#define Serial simSerial()
+
+// The firmware reads the RTC through these, after the standard headers declared the real ones
+#define gettimeofday(tv, tz) simGettimeofday(tv)
+#define time(out) simTime(out)
+
+#endif // SIM_ARDUINO_H
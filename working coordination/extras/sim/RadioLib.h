@@ -0,0 +1,501 @@
+/**
+ * @file RadioLib.h
+ * @brief This file contains the native stand-in for the RadioLib SX1262 driver and the shared LoRa medium of the simulator.
+ *
+ * The SX1262 model keeps the chip state the firmware depends on (standby, sleep with or without
+ * retained configuration, continuous and duty-cycled receive, transmit) and raises DIO1 on RX and
+ * TX done. Packets travel through SimMedium, which decides per receiver whether the packet arrives.
+ */
+
+#ifndef SIM_RADIOLIB_H
+#define SIM_RADIOLIB_H
+
+#include <Arduino.h>
+#include <vector>
+
+#define RADIOLIB_ERR_NONE 0
+#define RADIOLIB_ERR_UNKNOWN -1
+#define RADIOLIB_ERR_MEMORY_ALLOCATION_FAILED -3
+#define RADIOLIB_ERR_TX_TIMEOUT -5
+#define RADIOLIB_ERR_RX_TIMEOUT -6
+#define RADIOLIB_ERR_WRONG_MODEM -20
+#define RADIOLIB_SX126X_SYNC_WORD_PRIVATE 0x12
+#define RADIOLIB_ASSERT(STATEVAR) { if ((STATEVAR) != RADIOLIB_ERR_NONE) { return (STATEVAR); } }
+
+/**
+ * @struct RadioLibHal
+ * @brief Pin access of the module, a no-op in the simulator.
+ */
+struct RadioLibHal {
+    const uint32_t GpioModeInput = 1;
+    void pinMode(uint32_t, uint32_t) {}
+};
+
+/**
+ * @class Module
+ * @brief SPI and IRQ pins of the radio, a no-op in the simulator.
+ */
+class Module {
+public:
+    Module(int, int, int, int) : hal(&pins) {}
+    void init() {}
+    uint32_t getIrq() const { return 0; }
+    uint32_t getGpio() const { return 0; }
+    RadioLibHal* hal;
+
+private:
+    RadioLibHal pins;
+};
+
+class SimMedium;
+
+/**
+ * @class SX1262
+ * @brief Behavioural SX1262 model with the RadioLib calls the firmware makes.
+ */
+class SX1262 {
+public:
+    static constexpr float NOISE_FLOOR_DBM = -117.0f; // Thermal noise at 250 kHz plus a 6 dB noise figure
+
+    /**
+     * @enum Mode
+     * @brief Operating mode of the chip.
+     */
+    enum Mode {
+        MODE_SLEEP,
+        MODE_STANDBY,
+        MODE_TX,
+        MODE_RX,
+        MODE_RX_DUTY
+    };
+
+    explicit SX1262(Module* module)
+        : _module(module), _node(NULL), _linkSnr(0), _mode(MODE_SLEEP), _modeSinceUs(0), _configured(false),
+          _frequency(0), _bandwidth(0), _spreadingFactor(0), _codingRate(0), _syncWord(0), _outputPower(0), _preambleLength(0),
+          _dutyPreamble(0), _dutyMinSymbols(0), _txId(0), _rxLength(0), _rxSnr(0), _dio1(NULL), _txAirUs(0), _rxOnUs(0) {}
+
+    /**
+     * @brief Connects the radio to its node, called once by the simulator.
+     * @param node The node owning the radio.
+     * @param linkSnr SNR of the node's link to the host at full power, in dB.
+     */
+    void attach(SimNode& node, float linkSnr) {
+        _node = &node;
+        _linkSnr = linkSnr;
+        node.radio = this;
+    }
+
+    int16_t begin(float frequency, float bandwidth, uint8_t spreadingFactor, uint8_t codingRate, uint8_t syncWord, int8_t power, uint16_t preambleLength, float, bool) {
+        _frequency = frequency;
+        _bandwidth = bandwidth;
+        _spreadingFactor = spreadingFactor;
+        _codingRate = codingRate;
+        _syncWord = syncWord;
+        _outputPower = power;
+        _preambleLength = preambleLength;
+        _configured = true;
+        setMode(MODE_STANDBY);
+        return RADIOLIB_ERR_NONE;
+    }
+
+    int16_t standby() {
+        setMode(MODE_STANDBY);
+        return RADIOLIB_ERR_NONE;
+    }
+
+    int16_t sleep(bool retainConfig = true) {
+        setMode(MODE_SLEEP);
+        _configured = _configured && retainConfig;
+        return RADIOLIB_ERR_NONE;
+    }
+
+    int16_t setFrequency(float frequency, bool = true) { return configure(_frequency, frequency); }
+    int16_t setBandwidth(float bandwidth) { return configure(_bandwidth, bandwidth); }
+    int16_t setSpreadingFactor(uint8_t spreadingFactor) { return configure(_spreadingFactor, spreadingFactor); }
+    int16_t setCodingRate(uint8_t codingRate) { return configure(_codingRate, codingRate); }
+    int16_t setSyncWord(uint8_t syncWord, uint8_t = 0x44) { return configure(_syncWord, syncWord); }
+    int16_t setOutputPower(int8_t power) { return configure(_outputPower, power); }
+    int16_t setPreambleLength(uint16_t preambleLength) { return configure(_preambleLength, preambleLength); }
+    int16_t setCRC(uint8_t, uint16_t = 0x1D0F, uint16_t = 0x1021, bool = true) { return configuredState(); }
+    int16_t invertIQ(bool) { return configuredState(); }
+    int16_t autoLDRO() { return configuredState(); }
+
+    Module* getMod() { return _module; }
+    void setDio1Action(void (*action)(void)) { _dio1 = action; }
+    void clearDio1Action() { _dio1 = NULL; }
+
+    int16_t startReceive() {
+        clearIrq();
+        setMode(MODE_RX);
+        return RADIOLIB_ERR_NONE;
+    }
+
+    int16_t startReceiveDutyCycleAuto(uint16_t senderPreambleLength = 8, uint16_t minSymbols = 8, uint16_t = 0) {
+        _dutyPreamble = senderPreambleLength;
+        _dutyMinSymbols = minSymbols;
+        clearIrq();
+        setMode(MODE_RX_DUTY);
+        return RADIOLIB_ERR_NONE;
+    }
+
+    size_t getPacketLength(bool = true) const { return _rxLength; }
+
+    int16_t readData(uint8_t* data, size_t length) {
+        memcpy(data, _rxData, length < _rxLength ? length : _rxLength);
+        clearIrq();
+        return RADIOLIB_ERR_NONE;
+    }
+
+    float getSNR() const { return _rxSnr; }
+    float getRSSI() const { return NOISE_FLOOR_DBM + _rxSnr; }
+
+    /**
+     * @brief Computes the time on air with the Semtech formula: explicit header, CRC on, LDRO above 16.38 ms symbols.
+     * @param length Payload length in bytes.
+     * @return The time on air in microseconds.
+     */
+    uint32_t getTimeOnAir(size_t length) const {
+        double symbolUs = symbolTimeUs();
+        int lowDataRate = symbolUs >= 16380.0 ? 1 : 0;
+        int numerator = 8 * (int)length - 4 * _spreadingFactor + 28 + 16;
+        int denominator = 4 * (_spreadingFactor - 2 * lowDataRate);
+        int blocks = numerator > 0 ? (numerator + denominator - 1) / denominator : 0;
+        double symbols = (_preambleLength + 4.25) + 8 + blocks * _codingRate;
+        return (uint32_t)(symbols * symbolUs);
+    }
+
+    int16_t startTransmit(const uint8_t* data, size_t length, uint8_t = 0);
+
+    int16_t finishTransmit() {
+        clearIrq();
+        setMode(MODE_STANDBY);
+        return RADIOLIB_ERR_NONE;
+    }
+
+    /**
+     * @brief Getter for the time spent transmitting.
+     * @return The transmit time in microseconds.
+     */
+    int64_t getTxAirUs() const { return _txAirUs; }
+
+    /**
+     * @brief Getter for the time the receiver was powered, counting only the listen windows of duty-cycled receive.
+     * @return The receive time in microseconds.
+     */
+    int64_t getRxOnUs() const { return _rxOnUs; }
+
+    /**
+     * @brief Getter for the SNR of the node's link to the host.
+     * @return The SNR at full power in dB.
+     */
+    float getLinkSnr() const { return _linkSnr; }
+
+private:
+    friend class SimMedium;
+
+    Module* _module;           // Module passed to the constructor
+    SimNode* _node;            // Node owning the radio
+    float _linkSnr;            // SNR of the link to the host at full power
+    Mode _mode;                // Current operating mode
+    int64_t _modeSinceUs;      // Virtual time the current mode was entered
+    bool _configured;          // False after a reset or a sleep without retention
+    float _frequency;          // Carrier frequency in MHz
+    float _bandwidth;          // Bandwidth in kHz
+    uint8_t _spreadingFactor;  // Spreading factor
+    uint8_t _codingRate;       // Coding rate denominator (4/x)
+    uint8_t _syncWord;         // LoRa sync word
+    int8_t _outputPower;       // Transmit power in dBm
+    uint16_t _preambleLength;  // Preamble length in symbols
+    uint16_t _dutyPreamble;    // Sender preamble the duty cycle was sized for
+    uint16_t _dutyMinSymbols;  // Preamble symbols each duty-cycle listen window needs
+    uint64_t _txId;            // Transmission on air, 0 for none
+    uint8_t _rxData[256];      // Last received packet
+    size_t _rxLength;          // Length of the last received packet
+    float _rxSnr;              // SNR of the last received packet
+    void (*_dio1)(void);       // DIO1 handler of the firmware
+    int64_t _txAirUs;          // Accumulated transmit time
+    int64_t _rxOnUs;           // Accumulated receiver on time
+
+    double symbolTimeUs() const {
+        return _bandwidth > 0 ? (double)(1 << _spreadingFactor) * 1000.0 / _bandwidth : 0;
+    }
+
+    /**
+     * @brief Fraction of the time the receiver is on in the RX duty-cycle mode, as sized by RadioLib.
+     */
+    double dutyRatio() const {
+        double sleepSymbols = (double)_dutyPreamble - 2.0 * _dutyMinSymbols;
+        double wakeSymbols = (double)_dutyMinSymbols + 1;
+        return sleepSymbols > 0 ? wakeSymbols / (wakeSymbols + sleepSymbols) : 1.0;
+    }
+
+    template <typename T, typename V>
+    int16_t configure(T& field, V value) {
+        if (!_configured) {
+            return RADIOLIB_ERR_WRONG_MODEM; // Lost configuration reads back as the wrong packet type
+        }
+        field = (T)value;
+        return RADIOLIB_ERR_NONE;
+    }
+
+    int16_t configuredState() const {
+        return _configured ? RADIOLIB_ERR_NONE : RADIOLIB_ERR_WRONG_MODEM;
+    }
+
+    void setMode(Mode mode) {
+        int64_t now = SimKernel::instance().now();
+        int64_t elapsed = now - _modeSinceUs;
+        if (_mode == MODE_RX) {
+            _rxOnUs += elapsed;
+        } else if (_mode == MODE_RX_DUTY) {
+            _rxOnUs += (int64_t)(elapsed * dutyRatio());
+        } else if (_mode == MODE_TX) {
+            _txAirUs += elapsed;
+        }
+        if (_mode == MODE_TX && mode != MODE_TX) {
+            _txId = 0;
+        }
+        _mode = mode;
+        _modeSinceUs = now;
+    }
+
+    /**
+     * @brief Sets DIO1 high: runs the firmware's handler, or wakes the node from light sleep on the level.
+     */
+    void raiseDio1() {
+        if (_node == NULL) {
+            return;
+        }
+        _node->irqLevel = true;
+        if (_dio1 != NULL) {
+            SimKernel::instance().interrupt(*_node, _dio1);
+        } else if (_node->lightSleeping) {
+            SimKernel::instance().notify(_node);
+        }
+    }
+
+    void clearIrq() {
+        if (_node != NULL) {
+            _node->irqLevel = false;
+        }
+    }
+};
+
+/**
+ * @class SimMedium
+ * @brief The shared channel: decides which receivers get a packet when it ends.
+ *
+ * A receiver gets a packet if it is on the packet's frequency, bandwidth, spreading factor and
+ * sync word, was listening early enough to catch the preamble and kept listening until the end,
+ * no other packet on the same channel overlapped with it, the link SNR reaches the demodulation
+ * floor of the spreading factor, and the packet survives the random loss.
+ */
+class SimMedium {
+public:
+    static const int PREAMBLE_LOCK_SYMBOLS = 4; // Preamble symbols a continuous receiver needs to lock on
+
+    /**
+     * @struct Stats
+     * @brief Fate of the packets at the receivers that were listening for them.
+     */
+    struct Stats {
+        uint64_t sent;       // Packets transmitted
+        uint64_t delivered;  // Packets handed to a receiver
+        uint64_t collided;   // Lost to an overlapping packet
+        uint64_t weak;       // Lost below the demodulation floor
+        uint64_t dropped;    // Lost to the random loss
+    };
+
+    static SimMedium& instance() {
+        static SimMedium medium;
+        return medium;
+    }
+
+    /**
+     * @brief Sets the probability that a packet which would arrive is lost anyway.
+     * @param lossRate Loss probability, 0 to 1.
+     */
+    void setLossRate(double lossRate) { _lossRate = lossRate; }
+
+    const Stats& getStats() const { return _stats; }
+
+    /**
+     * @brief Registers a radio as a possible receiver.
+     * @param radio The radio.
+     */
+    void add(SX1262& radio) { _radios.push_back(&radio); }
+
+    /**
+     * @brief Puts a packet on air and schedules its end.
+     * @param sender The transmitting radio, already in MODE_TX.
+     * @param data The packet.
+     * @param length The packet length.
+     * @return The transmission identifier.
+     */
+    uint64_t transmit(SX1262& sender, const uint8_t* data, size_t length) {
+        SimKernel& kernel = SimKernel::instance();
+        Transmission tx;
+        tx.id = ++_lastId;
+        tx.sender = &sender;
+        tx.startUs = kernel.now();
+        tx.endUs = tx.startUs + sender.getTimeOnAir(length);
+        tx.frequency = sender._frequency;
+        tx.bandwidth = sender._bandwidth;
+        tx.spreadingFactor = sender._spreadingFactor;
+        tx.syncWord = sender._syncWord;
+        tx.preambleLength = sender._preambleLength;
+        tx.power = sender._outputPower;
+        tx.length = length < sizeof(tx.data) ? length : sizeof(tx.data);
+        memcpy(tx.data, data, tx.length);
+        _onAir.push_back(tx);
+        _stats.sent++;
+
+        uint64_t id = tx.id;
+        kernel.schedule(tx.endUs, [this, id] { end(id); });
+        return id;
+    }
+
+private:
+    /**
+     * @struct Transmission
+     * @brief A packet on air.
+     */
+    struct Transmission {
+        uint64_t id;
+        SX1262* sender;
+        int64_t startUs;
+        int64_t endUs;
+        float frequency;
+        float bandwidth;
+        uint8_t spreadingFactor;
+        uint8_t syncWord;
+        uint16_t preambleLength;
+        int8_t power;
+        uint8_t data[256];
+        size_t length;
+    };
+
+    std::vector<SX1262*> _radios;      // All radios
+    std::vector<Transmission> _onAir;  // Packets that may still overlap with a pending one
+    uint64_t _lastId = 0;              // Identifier of the last transmission
+    double _lossRate = 0;              // Random loss probability
+    Stats _stats = Stats();            // Packet fates
+
+    static bool sameChannel(const Transmission& a, const Transmission& b) {
+        return a.frequency == b.frequency && a.bandwidth == b.bandwidth && a.spreadingFactor == b.spreadingFactor;
+    }
+
+    static bool tunedTo(const SX1262& radio, const Transmission& tx) {
+        return radio._frequency == tx.frequency && radio._bandwidth == tx.bandwidth &&
+               radio._spreadingFactor == tx.spreadingFactor && radio._syncWord == tx.syncWord;
+    }
+
+    /**
+     * @brief Checks whether a receiver caught the preamble and listened through the whole packet.
+     */
+    static bool listening(const SX1262& radio, const Transmission& tx) {
+        double symbolUs = radio.symbolTimeUs();
+        if (radio._mode == SX1262::MODE_RX) {
+            return radio._modeSinceUs <= tx.startUs + (int64_t)((tx.preambleLength - PREAMBLE_LOCK_SYMBOLS) * symbolUs);
+        }
+        if (radio._mode == SX1262::MODE_RX_DUTY) {
+            return tx.preambleLength >= radio._dutyPreamble &&
+                   radio._modeSinceUs <= tx.startUs + (int64_t)((tx.preambleLength - radio._dutyMinSymbols) * symbolUs);
+        }
+        return false;
+    }
+
+    /**
+     * @brief Ends a transmission: delivers it and raises TX done at the sender.
+     * @param id The transmission identifier.
+     */
+    void end(uint64_t id) {
+        size_t index = 0;
+        while (index < _onAir.size() && _onAir[index].id != id) {
+            index++;
+        }
+        if (index == _onAir.size()) {
+            return;
+        }
+        Transmission tx = _onAir[index];
+
+        for (size_t i = 0; i < _radios.size(); ++i) {
+            SX1262& receiver = *_radios[i];
+            if (&receiver == tx.sender || !tunedTo(receiver, tx) || !listening(receiver, tx)) {
+                continue;
+            }
+            if (collides(tx, receiver)) {
+                _stats.collided++;
+                continue;
+            }
+            float senderSnr = tx.sender->_linkSnr < receiver._linkSnr ? tx.sender->_linkSnr : receiver._linkSnr;
+            float snr = senderSnr - (20 - tx.power);
+            if (snr < -7.5f - 2.5f * (tx.spreadingFactor - 7)) {
+                _stats.weak++;
+                continue;
+            }
+            if (std::uniform_real_distribution<double>(0, 1)(simRandom()) < _lossRate) {
+                _stats.dropped++;
+                continue;
+            }
+            memcpy(receiver._rxData, tx.data, tx.length);
+            receiver._rxLength = tx.length;
+            receiver._rxSnr = snr;
+            receiver.setMode(SX1262::MODE_STANDBY); // RX done, the firmware restarts the receiver
+            _stats.delivered++;
+            receiver.raiseDio1();
+        }
+
+        if (tx.sender->_txId == id) {
+            tx.sender->setMode(SX1262::MODE_STANDBY);
+            tx.sender->raiseDio1();
+        }
+        prune(SimKernel::instance().now());
+    }
+
+    /**
+     * @brief Checks whether another packet on the same channel overlapped with a transmission.
+     */
+    bool collides(const Transmission& tx, const SX1262& receiver) const {
+        for (size_t i = 0; i < _onAir.size(); ++i) {
+            const Transmission& other = _onAir[i];
+            if (other.id != tx.id && other.sender != &receiver && sameChannel(other, tx) &&
+                other.startUs < tx.endUs && other.endUs > tx.startUs) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Forgets transmissions that can no longer overlap with one still on air.
+     */
+    void prune(int64_t nowUs) {
+        // A packet ending now may still be waiting for its end(), as happens to packets sent in the same slot
+        int64_t oldestStartUs = nowUs;
+        for (size_t i = 0; i < _onAir.size(); ++i) {
+            if (_onAir[i].endUs >= nowUs && _onAir[i].startUs < oldestStartUs) {
+                oldestStartUs = _onAir[i].startUs;
+            }
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < _onAir.size(); ++i) {
+            if (_onAir[i].endUs >= nowUs || _onAir[i].endUs > oldestStartUs) {
+                _onAir[kept++] = _onAir[i];
+            }
+        }
+        _onAir.resize(kept);
+    }
+};
+
+inline int16_t SX1262::startTransmit(const uint8_t* data, size_t length, uint8_t) {
+    if (!_configured) {
+        return RADIOLIB_ERR_WRONG_MODEM;
+    }
+    clearIrq();
+    setMode(MODE_TX);
+    _txId = SimMedium::instance().transmit(*this, data, length);
+    return RADIOLIB_ERR_NONE;
+}
+
+#endif // SIM_RADIOLIB_H
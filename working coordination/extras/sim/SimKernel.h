@@ -0,0 +1,366 @@
+/**
+ * @file SimKernel.h
+ * @brief This file contains the SimKernel class, a discrete-event scheduler that runs the firmware of many virtual nodes against one virtual clock.
+ */
+
+#ifndef SIM_KERNEL_H
+#define SIM_KERNEL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+class SX1262;
+
+/**
+ * @struct SimStop
+ * @brief Thrown out of a blocking call when the simulation ends, unwinding the node's firmware.
+ */
+struct SimStop {};
+
+/**
+ * @struct SimNode
+ * @brief One virtual board: its clocks, its FreeRTOS notification and its radio.
+ *
+ * Each node keeps its own local clock, which runs at (1 + drift) times the virtual clock,
+ * so crystal and RTC errors affect the firmware exactly where it reads the time.
+ */
+struct SimNode {
+    int index;                  // Position in the kernel's node list
+    double drift;               // Clock rate error, e.g. 20e-6 for +20 ppm
+    int64_t wallOffsetUs;       // Local wall clock at virtual time 0
+    int64_t bootLocalUs;        // Local wall clock at the last boot, origin of millis() and esp_timer_get_time()
+    uint64_t mac;               // Value of ESP.getEfuseMac()
+    SX1262* radio;              // The node's radio, NULL before it is attached
+    std::condition_variable cv; // Signalled when the node may run
+    int64_t wakeAtUs;           // Virtual time the blocked node resumes, INT64_MAX for never
+    bool waitingNotify;         // True while blocked in ulTaskNotifyTake()
+    uint32_t notifyCount;       // FreeRTOS notification value
+    bool finished;              // True once the node's thread returned
+    uint32_t spinCount;         // Clock reads since the node last blocked, catches busy loops
+    bool irqLevel;              // Level of the radio's DIO1 pin, high from an IRQ until the firmware clears it
+    bool lightSleeping;         // True while in esp_light_sleep_start(), woken by DIO1 or the sleep timer
+    int64_t sleepTimerUs;       // Armed sleep timer wakeup in microseconds, negative for none
+    int64_t lightSleepUs;       // Virtual time spent in light sleep
+    std::string line;           // Serial output of the current line
+    std::thread thread;         // Thread running the firmware
+};
+
+/**
+ * @class SimKernel
+ * @brief Lockstep scheduler: exactly one node thread runs at a time and code takes no virtual time.
+ *
+ * A node only gives up the CPU in a blocking call (delay(), ulTaskNotifyTake(), light or deep sleep).
+ * The kernel then advances the virtual clock to the earliest pending event, which is either a
+ * node timeout, a pending notification or a medium event such as the end of a packet, and runs it.
+ * Because only one thread runs at a time and ties are broken by order, a run is reproducible
+ * from its seed.
+ */
+class SimKernel {
+public:
+    static const int64_t NEVER = INT64_MAX;           // Wake time of a node waiting without timeout
+    static const uint32_t MAX_SPINS = 10000000;      // Clock reads without blocking before a node is considered stuck
+
+    /**
+     * @brief Accessor for the single kernel of the process.
+     * @return The kernel.
+     */
+    static SimKernel& instance() {
+        static SimKernel kernel;
+        return kernel;
+    }
+
+    /**
+     * @brief Creates a node.
+     * @param drift Clock rate error of the node.
+     * @param wallOffsetUs Local wall clock at virtual time 0.
+     * @param mac Value the node reads from ESP.getEfuseMac().
+     * @return The node, owned by the kernel.
+     */
+    SimNode& addNode(double drift, int64_t wallOffsetUs, uint64_t mac) {
+        SimNode* node = new SimNode();
+        node->index = (int)nodes.size();
+        node->drift = drift;
+        node->wallOffsetUs = wallOffsetUs;
+        node->bootLocalUs = 0;
+        node->mac = mac;
+        node->radio = NULL;
+        node->wakeAtUs = NEVER;
+        node->waitingNotify = false;
+        node->notifyCount = 0;
+        node->finished = false;
+        node->spinCount = 0;
+        node->irqLevel = false;
+        node->lightSleeping = false;
+        node->sleepTimerUs = -1;
+        node->lightSleepUs = 0;
+        nodes.push_back(node);
+        return *node;
+    }
+
+    /**
+     * @brief Starts a node's firmware at a virtual time.
+     * @param node The node.
+     * @param bootAtUs Virtual time of the first boot.
+     * @param body The firmware, runs until the simulation ends.
+     */
+    void start(SimNode& node, int64_t bootAtUs, std::function<void()> body) {
+        node.wakeAtUs = bootAtUs;
+        node.thread = std::thread(&SimKernel::threadMain, this, &node, body);
+    }
+
+    /**
+     * @brief Runs the simulation.
+     * @param endUs Virtual time at which all nodes are stopped.
+     */
+    void run(int64_t endUs) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            kernelCv.wait(lock, [this] { return current == NULL; });
+
+            SimNode* next = NULL;
+            int64_t nodeAt = NEVER;
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                SimNode* node = nodes[i];
+                if (node->finished) {
+                    continue;
+                }
+                int64_t at = (node->waitingNotify && node->notifyCount > 0) ? nowUs : node->wakeAtUs;
+                if (at < nodeAt) {
+                    nodeAt = at;
+                    next = node;
+                }
+            }
+            int64_t eventAt = events.empty() ? NEVER : events.top().atUs;
+
+            if (eventAt <= nodeAt) {
+                if (eventAt > endUs) {
+                    break;
+                }
+                Event event = events.top();
+                events.pop();
+                nowUs = event.atUs;
+                event.action(); // Runs with no node thread active
+                continue;
+            }
+            if (next == NULL || nodeAt > endUs) {
+                break;
+            }
+            nowUs = nodeAt;
+            current = next;
+            next->cv.notify_one();
+        }
+
+        stopping = true;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            nodes[i]->cv.notify_all();
+        }
+        lock.unlock();
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i]->thread.joinable()) {
+                nodes[i]->thread.join();
+            }
+        }
+    }
+
+    /**
+     * @brief Schedules a medium event.
+     * @param atUs Virtual time of the event.
+     * @param action Callback run by the kernel while no node runs.
+     */
+    void schedule(int64_t atUs, std::function<void()> action) {
+        Event event;
+        event.atUs = atUs;
+        event.sequence = nextSequence++;
+        event.action = action;
+        events.push(event);
+    }
+
+    /**
+     * @brief Getter for the virtual time.
+     * @return The virtual time in microseconds.
+     */
+    int64_t now() const { return nowUs; }
+
+    /**
+     * @brief Node whose firmware is running, or whose radio raised the interrupt being delivered.
+     * @return The node, NULL outside node context.
+     */
+    SimNode* self() const { return isrNode != NULL ? isrNode : current; }
+
+    /**
+     * @brief Reads a node's local wall clock.
+     * @param node The node.
+     * @return The local wall clock in microseconds.
+     */
+    int64_t localUs(const SimNode& node) const {
+        return node.wallOffsetUs + nowUs + (int64_t)((double)nowUs * node.drift);
+    }
+
+    /**
+     * @brief Reads the running node's wall clock and checks that it is not spinning.
+     * @return The local wall clock in microseconds.
+     */
+    int64_t readClock() {
+        SimNode* node = self();
+        if (node == NULL) {
+            return nowUs;
+        }
+        if (++node->spinCount > MAX_SPINS) {
+            fprintf(stderr, "node %d reads the clock in a loop without blocking at %lld us\n", node->index, (long long)nowUs);
+            abort();
+        }
+        return localUs(*node);
+    }
+
+    /**
+     * @brief Blocks the running node for a local duration.
+     * @param localDurationUs Duration measured by the node's clock.
+     */
+    void sleepLocal(int64_t localDurationUs) {
+        SimNode& node = *current;
+        block(node, nowUs + toVirtual(node, localDurationUs), false);
+    }
+
+    /**
+     * @brief Restarts the running node's boot-relative clocks, as a reset does.
+     */
+    void reboot() {
+        current->bootLocalUs = localUs(*current);
+    }
+
+    /**
+     * @brief Implements ulTaskNotifyTake() for the running node.
+     * @param clear True to clear the notification value, false to decrement it.
+     * @param timeoutLocalUs Timeout measured by the node's clock, negative to wait forever.
+     * @return The notification value before it was cleared or decremented.
+     */
+    uint32_t take(bool clear, int64_t timeoutLocalUs) {
+        SimNode& node = *current;
+        if (node.notifyCount == 0 && timeoutLocalUs != 0) {
+            block(node, timeoutLocalUs < 0 ? NEVER : nowUs + toVirtual(node, timeoutLocalUs), true);
+        }
+        uint32_t value = node.notifyCount;
+        if (value > 0) {
+            node.notifyCount = clear ? 0 : value - 1;
+        }
+        return value;
+    }
+
+    /**
+     * @brief Delivers a radio interrupt to a node's firmware.
+     * @param node The node whose radio raised the interrupt.
+     * @param handler The DIO1 handler registered by the firmware.
+     */
+    void interrupt(SimNode& node, void (*handler)(void)) {
+        isrNode = &node;
+        handler();
+        isrNode = NULL;
+    }
+
+    /**
+     * @brief Implements vTaskNotifyGiveFromISR() and xTaskNotifyGive().
+     *
+     * The firmware keeps the task to notify in a static, which all virtual nodes share.
+     * The notification therefore goes to the node whose interrupt is being delivered.
+     * @param handle The handle passed by the firmware, used outside interrupt context.
+     */
+    void notify(void* handle) {
+        SimNode* node = isrNode != NULL ? isrNode : static_cast<SimNode*>(handle);
+        if (node != NULL) {
+            node->notifyCount++;
+        }
+    }
+
+private:
+    /**
+     * @struct Event
+     * @brief A pending medium event.
+     */
+    struct Event {
+        int64_t atUs;                 // Virtual time of the event
+        uint64_t sequence;            // Creation order, breaks ties
+        std::function<void()> action; // Callback
+        bool operator<(const Event& other) const {
+            return atUs != other.atUs ? atUs > other.atUs : sequence > other.sequence; // Earliest first
+        }
+    };
+
+    std::mutex mutex;                   // Guards the hand-over between the kernel and the node threads
+    std::condition_variable kernelCv;   // Signalled when the running node blocks
+    std::vector<SimNode*> nodes;        // All nodes
+    std::priority_queue<Event> events;  // Pending medium events
+    SimNode* current = NULL;            // Node whose thread runs, NULL while the kernel runs
+    SimNode* isrNode = NULL;            // Node whose interrupt is being delivered
+    int64_t nowUs = 0;                  // Virtual time
+    uint64_t nextSequence = 0;          // Sequence number of the next event
+    bool stopping = false;              // Set once the simulation has ended
+
+    /**
+     * @brief Converts a duration on a node's clock to virtual time, rounding up.
+     * @param node The node.
+     * @param localDurationUs The local duration.
+     * @return The virtual duration.
+     */
+    static int64_t toVirtual(const SimNode& node, int64_t localDurationUs) {
+        double duration = (double)localDurationUs / (1.0 + node.drift);
+        int64_t rounded = (int64_t)duration;
+        return rounded < duration ? rounded + 1 : rounded;
+    }
+
+    /**
+     * @brief Hands the CPU back to the kernel until the node is resumed.
+     * @param node The running node.
+     * @param wakeAtUs Virtual time to resume at, NEVER to wait for a notification only.
+     * @param onNotify True to also resume on a notification.
+     */
+    void block(SimNode& node, int64_t wakeAtUs, bool onNotify) {
+        std::unique_lock<std::mutex> lock(mutex);
+        node.wakeAtUs = wakeAtUs;
+        node.waitingNotify = onNotify;
+        node.spinCount = 0;
+        current = NULL;
+        kernelCv.notify_one();
+        node.cv.wait(lock, [this, &node] { return current == &node || stopping; });
+        node.waitingNotify = false;
+        if (stopping) {
+            throw SimStop();
+        }
+    }
+
+    /**
+     * @brief Thread entry point of a node.
+     * @param node The node.
+     * @param body The firmware.
+     */
+    void threadMain(SimNode* node, std::function<void()> body) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            node->cv.wait(lock, [this, node] { return current == node || stopping; });
+            if (stopping) {
+                node->finished = true;
+                return;
+            }
+        }
+        try {
+            body();
+        } catch (const SimStop&) {
+            // The simulation ended while the node was blocked
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        node->finished = true;
+        if (current == node) {
+            current = NULL;
+            kernelCv.notify_one();
+        }
+    }
+};
+
+#endif // SIM_KERNEL_H
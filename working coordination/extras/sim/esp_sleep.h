@@ -0,0 +1,52 @@
+/**
+ * @file esp_sleep.h
+ * @brief This file contains the native stand-in for the ESP-IDF light sleep API, backed by SimKernel.
+ *
+ * Deep sleep is run by the simulator itself, so only the calls of a light sleep are provided.
+ * Any GPIO wakeup is taken to be the radio's DIO1.
+ */
+
+#ifndef SIM_ESP_SLEEP_H
+#define SIM_ESP_SLEEP_H
+
+#include "SimKernel.h"
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED = 0,
+    ESP_SLEEP_WAKEUP_ALL = 1,
+    ESP_SLEEP_WAKEUP_TIMER = 4,
+    ESP_SLEEP_WAKEUP_GPIO = 7
+} esp_sleep_source_t;
+
+inline int esp_sleep_enable_timer_wakeup(uint64_t us) {
+    SimKernel::instance().self()->sleepTimerUs = (int64_t)us;
+    return 0;
+}
+
+inline int esp_sleep_enable_gpio_wakeup() { return 0; }
+
+inline int esp_sleep_disable_wakeup_source(esp_sleep_source_t source) {
+    if (source == ESP_SLEEP_WAKEUP_ALL || source == ESP_SLEEP_WAKEUP_TIMER) {
+        SimKernel::instance().self()->sleepTimerUs = -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Sleeps the running node until DIO1 goes high or the armed timer fires.
+ * @return 0.
+ */
+inline int esp_light_sleep_start() {
+    SimKernel& kernel = SimKernel::instance();
+    SimNode* node = kernel.self();
+    int64_t startUs = kernel.now();
+    node->lightSleeping = true;
+    if (!node->irqLevel) {
+        kernel.take(false, node->sleepTimerUs);
+    }
+    node->lightSleeping = false;
+    node->lightSleepUs += kernel.now() - startUs;
+    return 0;
+}
+
+#endif // SIM_ESP_SLEEP_H
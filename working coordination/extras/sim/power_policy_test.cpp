@@ -0,0 +1,71 @@
+/**
+ * @file power_policy_test.cpp
+ * @brief This file contains native checks of the client intervals PowerPolicy derives from the cell's interval.
+ *
+ * Build and run from the "working coordination" directory:
+ *   g++ -std=gnu++11 -O2 -pthread -I extras/sim -I src extras/sim/power_policy_test.cpp -o power_policy_test
+ *   ./power_policy_test
+ */
+
+#include <stdio.h>
+#include "SimKernel.h"
+#include <Arduino.h>
+#include "ClientTable.h"
+#include "PowerPolicy.h"
+
+static int failures = 0; // Checks that did not hold
+
+/**
+ * @brief Reports a check that did not hold.
+ * @param ok The checked condition.
+ * @param what Description of the check.
+ */
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        printf("FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+/**
+ * @brief Acknowledges a client with its own interval and returns the cycles it sleeps through.
+ * @param cellInterval Message interval of the cell.
+ * @param clientInterval Message interval of the client.
+ * @return The client's skipCycles after the ACK.
+ */
+static uint8_t skipCyclesFor(uint16_t cellInterval, uint16_t clientInterval) {
+    ClientTable clients;
+    clients.reset();
+    clients.setSchedule(1, clientInterval, 5, 1);
+    return clients.markAcked(1, 0, cellInterval)->skipCycles;
+}
+
+int main() {
+    // A client at or above the host's level follows the cell
+    check(PowerPolicy::clientIntervalFor(10, 0, 0) == 10, "same level follows the cell");
+    check(PowerPolicy::clientIntervalFor(40, 2, 1) == 40, "higher level follows the cell");
+
+    // Doubling per level the client is below the host, starting from the cell's interval
+    check(PowerPolicy::clientIntervalFor(20, 1, 3) == 80, "host at level 1, client at level 3");
+    check(skipCyclesFor(20, 80) == 3, "client at 80 s sleeps through 3 cycles of 20 s");
+
+    // The host stretched its interval beyond the base one to fit the beacon window
+    uint16_t stretched = 23;
+    uint16_t client = PowerPolicy::clientIntervalFor(stretched, 0, 2);
+    check(client == 92, "stretched cell interval doubles twice");
+    check(client % stretched == 0, "client interval is a multiple of the stretched cell interval");
+    check(skipCyclesFor(stretched, client) == 3, "client sleeps through 3 stretched cycles");
+
+    // Doubling beyond the 14-bit interval field stops at a multiple of the cell's interval
+    uint16_t cell = 3000;
+    client = PowerPolicy::clientIntervalFor(cell, 0, 3);
+    check(client == 15000, "clamped interval is the largest multiple of the cell below the limit");
+    check(client <= Timer::MAX_MESSAGE_INTERVAL, "clamped interval fits the schedule field");
+    check(skipCyclesFor(cell, client) == 4, "clamped client sleeps through 4 cycles");
+    check(PowerPolicy::clientIntervalFor(Timer::MAX_MESSAGE_INTERVAL, 0, 3) == Timer::MAX_MESSAGE_INTERVAL, "cell at the limit keeps the client in step");
+
+    if (failures == 0) {
+        printf("All PowerPolicy checks passed.\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,309 @@
+/**
+ * @file simulate.cpp
+ * @brief This file contains a native discrete-event simulation of a cell running the wake-up coordination firmware.
+ *
+ * Every node runs the unmodified firmware headers against the stand-ins in this directory:
+ * Arduino.h and esp_sleep.h map the clock, FreeRTOS notifications and sleep onto SimKernel, and
+ * RadioLib.h models the SX1262 and the shared channel. Nodes get their own clock drift,
+ * boot latency and link SNR, and packets are lost to collisions, weak links and random loss.
+ *
+ * Build and run from the "working coordination" directory:
+ *   g++ -std=gnu++11 -O2 -pthread -I extras/sim -I src extras/sim/simulate.cpp -o coordination_sim
+ *   ./coordination_sim --nodes 20 --cycles 50 --loss 0.05 --drift 40
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <functional>
+#include <random>
+#include <vector>
+#include "SimKernel.h"
+#include <Arduino.h>
+#include <RadioLib.h>
+#include "WakeUpCoordination.h"
+#include "CoordinationState.h"
+#include "RadioConfig.h"
+#include "ChannelPlan.h"
+
+/**
+ * @struct SimOptions
+ * @brief Command line settings of a run.
+ */
+struct SimOptions {
+    int nodes = 10;            // Clients in the cell, besides the host
+    int cycles = 30;           // Host cycles to simulate
+    double loss = 0;           // Random packet loss probability
+    double driftPpm = 20;      // Clock drift of each node, uniform in +/- this many ppm
+    uint32_t seed = 1;         // Seed of every random choice
+    double snrMin = 0;         // Lowest client link SNR at full power in dB
+    double snrMax = 10;        // Highest client link SNR at full power in dB
+    int bootMs = 30;           // Time from a timer wake to setup()
+    bool lightSleep = false;   // Light-sleep the host between beacons, as HOST_LIGHT_SLEEP in examples/main
+    int channels = 8;          // Channels the cell hops over, as HOP_CHANNELS in examples/main
+    double dutyCycle = 0;      // Airtime limit of the sub-band, as DUTY_CYCLE in examples/main, 0 for none
+    double battery = -1;       // Battery charge of every client in percent, negative for unknown
+    double hostBattery = -1;   // Battery charge of the host in percent, negative for unknown
+    bool verbose = false;      // Print every node's Serial output
+    bool trace = false;        // Dump the cycle trace of the first client at the end
+};
+
+/**
+ * @struct SimNodeStats
+ * @brief Per-node results, written by the node's thread.
+ */
+struct SimNodeStats {
+    uint32_t cycles = 0;       // Completed coordination cycles
+    uint32_t synced = 0;       // Cycles ending with a beacon received (client) or at least one ACK (host)
+    uint64_t acked = 0;        // Host: ACKs received, summed over the cycles
+    uint64_t known = 0;        // Host: registered clients, summed over the cycles
+    int64_t awakeUs = 0;       // Virtual time spent awake
+};
+
+/**
+ * @class SimBoard
+ * @brief One board: the radio, the RTC state and the firmware loop of main.ino.
+ */
+class SimBoard {
+public:
+    SimBoard(SimNode& node, bool isHost, float linkSnr, int bootMs, bool lightSleep, const ChannelPlan& channelPlan, float batteryPercent)
+        : module(0, 0, 0, 0), radio(&module), node(node), isHost(isHost), bootMs(bootMs), lightSleep(lightSleep),
+          channelPlan(channelPlan), batteryPercent(batteryPercent), state() {
+        radio.attach(node, linkSnr);
+        SimMedium::instance().add(radio);
+    }
+
+    /**
+     * @brief Runs boot, coordination and deep sleep forever, as radioTask() and enterDeepSleep() do.
+     */
+    void run() {
+        SimKernel& kernel = SimKernel::instance();
+        bool powerOn = true;
+        while (true) {
+            int64_t wakeUs = kernel.now();
+            kernel.reboot();
+            kernel.sleepLocal((int64_t)bootMs * 1000); // ROM bootloader and image load
+            int64_t setupStartUs = esp_timer_get_time();
+
+            if (powerOn || !state.isValid()) {
+                state.reset(RADIO_CONFIG, channelPlan);
+            }
+            powerOn = false;
+            state.trace.beginCycle();
+            state.trace.record(CycleTrace::PHASE_BOOT, 0, setupStartUs);
+            initializeRadio();
+
+            WakeUpCoordination coordinator(packetPool, WakeUpCoordination::defaultNodeId());
+            coordinator.setLightSleep(lightSleep);
+            coordinator.setBatteryPercent(batteryPercent);
+            uint64_t sleepUs = coordinator.coordinate(state, isHost, radio, led, display);
+
+            stats.cycles++;
+            if (isHost) {
+                stats.acked += state.clients.ackedCount();
+                stats.known += state.clients.size();
+                stats.synced += state.clients.ackedCount() > 0 ? 1 : 0;
+            } else {
+                stats.synced += state.missedWarmWindows == 0 ? 1 : 0;
+            }
+
+            state.setRadioRetained(radio.sleep(true) == RADIOLIB_ERR_NONE);
+            radio.clearDio1Action();
+            stats.awakeUs += kernel.now() - wakeUs;
+            kernel.sleepLocal((int64_t)sleepUs);
+        }
+    }
+
+    Module module;
+    SX1262 radio;
+    SimNode& node;
+    bool isHost;
+    int bootMs;
+    bool lightSleep;
+    ChannelPlan channelPlan;
+    float batteryPercent;    // Charge reported to the coordinator, negative for unknown
+    CoordinationState state; // RTC memory of the board
+    PacketPool packetPool;   // Received frames
+    SimNodeStats stats;
+
+    static const RadioConfig RADIO_CONFIG; // Same settings as main.ino
+
+private:
+    /**
+     * @brief Warm start or full initialization, as initializeRadio() in main.ino.
+     */
+    void initializeRadio() {
+        int64_t initStartUs = esp_timer_get_time();
+        int radioState = RADIOLIB_ERR_UNKNOWN;
+        if (state.isRadioRetained()) {
+            radioState = state.radio.warmStart(radio);
+        }
+        if (radioState != RADIOLIB_ERR_NONE) {
+            radioState = state.radio.begin(radio);
+        }
+        state.setRadioRetained(false);
+        state.trace.recordSince(CycleTrace::PHASE_RADIO_INIT, initStartUs);
+    }
+
+    static void led(int) {}
+    static void display(const char*, const char*) {}
+};
+
+const RadioConfig SimBoard::RADIO_CONFIG = {
+    915.0, 250.0, 9, 7, RADIOLIB_SX126X_SYNC_WORD_PRIVATE, 20, 8, 1.6, false
+};
+
+/**
+ * @brief Parses the command line.
+ * @return False if an argument is unknown.
+ */
+static bool parseOptions(int argc, char** argv, SimOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--verbose") == 0) {
+            options.verbose = true;
+            continue;
+        }
+        if (strcmp(arg, "--trace") == 0) {
+            options.trace = true;
+            continue;
+        }
+        if (strcmp(arg, "--light-sleep") == 0) {
+            options.lightSleep = true;
+            continue;
+        }
+        if (value == NULL) {
+            return false;
+        }
+        if (strcmp(arg, "--nodes") == 0) {
+            options.nodes = atoi(value);
+        } else if (strcmp(arg, "--cycles") == 0) {
+            options.cycles = atoi(value);
+        } else if (strcmp(arg, "--loss") == 0) {
+            options.loss = atof(value);
+        } else if (strcmp(arg, "--drift") == 0) {
+            options.driftPpm = atof(value);
+        } else if (strcmp(arg, "--seed") == 0) {
+            options.seed = (uint32_t)strtoul(value, NULL, 10);
+        } else if (strcmp(arg, "--snr-min") == 0) {
+            options.snrMin = atof(value);
+        } else if (strcmp(arg, "--snr-max") == 0) {
+            options.snrMax = atof(value);
+        } else if (strcmp(arg, "--boot-ms") == 0) {
+            options.bootMs = atoi(value);
+        } else if (strcmp(arg, "--channels") == 0) {
+            options.channels = atoi(value);
+        } else if (strcmp(arg, "--duty-cycle") == 0) {
+            options.dutyCycle = atof(value);
+        } else if (strcmp(arg, "--battery") == 0) {
+            options.battery = atof(value);
+        } else if (strcmp(arg, "--host-battery") == 0) {
+            options.hostBattery = atof(value);
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return options.nodes >= 0 && options.cycles > 0 && options.channels >= 1 && options.channels <= ChannelPlan::MAX_SUB_BAND_SIZE;
+}
+
+int main(int argc, char** argv) {
+    SimOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [--nodes N] [--cycles N] [--loss P] [--drift PPM] [--seed N]\n"
+                        "          [--snr-min DB] [--snr-max DB] [--boot-ms MS] [--channels N]\n"
+                        "          [--duty-cycle F] [--battery P] [--host-battery P]\n"
+                        "          [--light-sleep] [--verbose] [--trace]\n", argv[0]);
+        return 1;
+    }
+    Print::verbose() = options.verbose;
+    simRandom().seed(options.seed);
+    SimMedium::instance().setLossRate(options.loss);
+
+    std::mt19937 setup(options.seed ^ 0x5EEDu);
+    std::uniform_real_distribution<double> drift(-options.driftPpm * 1e-6, options.driftPpm * 1e-6);
+    std::uniform_real_distribution<double> snr(options.snrMin, options.snrMax);
+    std::uniform_int_distribution<int64_t> wallOffset(0, 3600LL * 1000000LL);
+    const int64_t EPOCH_US = 1700000000LL * 1000000LL; // Wall clock the boards start near
+    const int64_t CYCLE_US = 10LL * 1000000LL;          // Message interval the host announces
+
+    const ChannelPlan channelPlan = {SimBoard::RADIO_CONFIG.frequency, 0.4f, (uint8_t)options.channels, 0, (float)options.dutyCycle};
+
+    SimKernel& kernel = SimKernel::instance();
+    std::vector<SimBoard*> boards;
+    for (int i = 0; i <= options.nodes; ++i) {
+        bool isHost = i == 0;
+        uint64_t mac = ((uint64_t)setup() << 32) | setup();
+        SimNode& node = kernel.addNode(drift(setup), EPOCH_US + wallOffset(setup), mac);
+        boards.push_back(new SimBoard(node, isHost, isHost ? 1000.0f : (float)snr(setup), options.bootMs,
+                                      isHost && options.lightSleep, channelPlan,
+                                      (float)(isHost ? options.hostBattery : options.battery)));
+    }
+    for (size_t i = 0; i < boards.size(); ++i) {
+        SimBoard* board = boards[i];
+        int64_t bootAtUs = board->isHost ? 0 : (int64_t)(setup() % (uint32_t)CYCLE_US); // Clients power on during the first cycle
+        kernel.start(board->node, bootAtUs, [board] { board->run(); });
+    }
+    kernel.run(options.cycles * CYCLE_US);
+
+    SimNodeStats clients;
+    int64_t clientTxUs = 0;
+    int64_t clientRxUs = 0;
+    for (size_t i = 1; i < boards.size(); ++i) {
+        const SimBoard& board = *boards[i];
+        clients.cycles += board.stats.cycles;
+        clients.synced += board.stats.synced;
+        clients.awakeUs += board.stats.awakeUs;
+        clientTxUs += board.radio.getTxAirUs();
+        clientRxUs += board.radio.getRxOnUs();
+    }
+    const SimBoard& host = *boards[0];
+    const SimMedium::Stats& channel = SimMedium::instance().getStats();
+    double clientCycles = clients.cycles > 0 ? clients.cycles : 1;
+    double hostCycles = host.stats.cycles > 0 ? host.stats.cycles : 1;
+
+    printf("nodes %d, cycles %d, channels %d, loss %.3f, drift +/-%.0f ppm, seed %u\n",
+           options.nodes, options.cycles, options.channels, options.loss, options.driftPpm, (unsigned int)options.seed);
+    printf("clients: %u cycles, sync rate %.1f%%, awake %.1f ms/cycle, tx %.1f ms/cycle, rx %.1f ms/cycle\n",
+           (unsigned int)clients.cycles, 100.0 * clients.synced / clientCycles, clients.awakeUs / clientCycles / 1000.0,
+           clientTxUs / clientCycles / 1000.0, clientRxUs / clientCycles / 1000.0);
+    printf("host: %u cycles, ack rate %.1f%%, awake %.1f ms/cycle (%.1f in light sleep), tx %.1f ms/cycle, rx %.1f ms/cycle\n",
+           (unsigned int)host.stats.cycles, host.stats.known > 0 ? 100.0 * host.stats.acked / host.stats.known : 0.0,
+           host.stats.awakeUs / hostCycles / 1000.0, host.node.lightSleepUs / hostCycles / 1000.0,
+           host.radio.getTxAirUs() / hostCycles / 1000.0, host.radio.getRxOnUs() / hostCycles / 1000.0);
+    printf("channel: %llu sent, %llu delivered, %llu collided, %llu below sensitivity, %llu lost\n",
+           (unsigned long long)channel.sent, (unsigned long long)channel.delivered, (unsigned long long)channel.collided,
+           (unsigned long long)channel.weak, (unsigned long long)channel.dropped);
+    printf("airtime: %.2f%% of the channel\n", 100.0 * (clientTxUs + host.radio.getTxAirUs()) / (options.cycles * (double)CYCLE_US));
+    if (options.dutyCycle > 0) {
+        uint32_t clientsHeldBack = 0;
+        for (size_t i = 1; i < boards.size(); ++i) {
+            clientsHeldBack += boards[i]->state.metrics.get(LinkMetrics::FRAMES_HELD_BACK);
+        }
+        printf("airtime budget %.2f%%: host held back %u frames, clients %u\n", 100.0 * options.dutyCycle,
+               (unsigned int)host.state.metrics.get(LinkMetrics::FRAMES_HELD_BACK), (unsigned int)clientsHeldBack);
+    }
+    if (options.battery >= 0 || options.hostBattery >= 0) {
+        uint8_t saving = 0;
+        for (uint8_t i = 0; i < ClientTable::MAX_CLIENTS; ++i) {
+            const ClientTable::Entry& entry = host.state.clients.at(i);
+            saving += entry.used && entry.powerLevel > 0 ? 1 : 0;
+        }
+        printf("power: host level %u, %u clients saving power\n", (unsigned int)host.state.powerLevel, (unsigned int)saving);
+    }
+
+    if (options.verbose) {
+        for (size_t i = 1; i < boards.size(); ++i) {
+            const SimBoard& board = *boards[i];
+            printf("client %2u: link %5.1f dB, SF%u, %d dBm, drift learned %ld ppm, synced %u of %u\n",
+                   (unsigned int)i, board.radio.getLinkSnr(), (unsigned int)board.state.radio.spreadingFactor,
+                   (int)board.state.radio.outputPower, (long)board.state.scheduler.getDriftPpm(),
+                   (unsigned int)board.stats.synced, (unsigned int)board.stats.cycles);
+        }
+    }
+    if (options.trace && boards.size() > 1) {
+        boards[1]->state.trace.dump(Serial);
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file AdrEngine.h
+ * @brief This file contains the AdrEngine class, which picks the cell's spreading factor and each client's output power from measured link margins.
+ */
+
+#ifndef ADR_ENGINE_H
+#define ADR_ENGINE_H
+
+#include <Arduino.h>
+#include "ClientTable.h"
+
+/**
+ * @class AdrEngine
+ * @brief Adaptive data rate decisions for a cell.
+ *
+ * All nodes of a cell hear the same beacon, so the spreading factor is chosen for the
+ * weakest link and announced in the beacon for the next cycle. Output power is set per
+ * client through the ACK confirmation. Link margins are normalized to full power, so
+ * lowering a client's power does not make the cell step to a slower spreading factor.
+ */
+class AdrEngine {
+public:
+    static const uint8_t MIN_SPREADING_FACTOR = 7; // Fastest spreading factor the cell may use
+    static const int8_t TARGET_MARGIN_DB = 10;     // Margin kept above the demodulation floor
+    static const int8_t STEP_MARGIN_DB = 3;        // Extra margin required before a faster step (a step costs 2.5 dB)
+    static const int8_t MIN_OUTPUT_POWER = 2;      // Lowest output power commanded to a client in dBm
+    static const int8_t UNCONFIRMED_POWER_STEP = 3; // Power increase of a client whose ACK went unconfirmed
+    static const int8_t FILTER_WEIGHT = 4;         // Weight of the running margin average (1/FILTER_WEIGHT per sample)
+
+    /**
+     * @brief Returns the lowest SNR the SX126x demodulates at a spreading factor.
+     * @param spreadingFactor The spreading factor.
+     * @return The SNR limit in dB.
+     */
+    static float demodulationFloorDb(uint8_t spreadingFactor) {
+        return -7.5f - 2.5f * ((int)spreadingFactor - 7);
+    }
+
+    /**
+     * @brief Updates a client's margin history from an ACK and recomputes its output power.
+     * @param entry The client's entry.
+     * @param snr SNR of the ACK in dB.
+     * @param spreadingFactor Spreading factor the ACK was received at.
+     * @param usedPower Output power the client sent the ACK with.
+     * @param maxPower Output power limit of the cell.
+     * @param marginReliefDb Part of TARGET_MARGIN_DB the client gives up to save power, see PowerPolicy.
+     */
+    static void recordAck(ClientTable::Entry& entry, float snr, uint8_t spreadingFactor, int8_t usedPower, int8_t maxPower, int8_t marginReliefDb = 0) {
+        int margin = (int)lroundf(snr - demodulationFloorDb(spreadingFactor)) + (maxPower - usedPower);
+        margin = clamp(margin, -128, 127);
+        entry.marginDb = entry.hasMargin ? (int8_t)(entry.marginDb + (margin - entry.marginDb) / FILTER_WEIGHT) : (int8_t)margin;
+        entry.hasMargin = true;
+        entry.txPower = (int8_t)clamp(maxPower - (entry.marginDb - (TARGET_MARGIN_DB - marginReliefDb)), MIN_OUTPUT_POWER, maxPower);
+    }
+
+    /**
+     * @brief Chooses the spreading factor for the next cycle.
+     *
+     * A registered client that did not answer may have missed a spreading factor change,
+     * so any miss sends the cell back to its base rate, where lost clients rejoin. While a
+     * client sleeps through the next cycle the rate is held, since it would not hear the change.
+     * @param clients Client table as the finished cycle left it.
+     * @param current Spreading factor of the finished cycle.
+     * @param base Spreading factor the cell starts at, also the slowest one used.
+     * @return The spreading factor for the next cycle.
+     */
+    static uint8_t nextSpreadingFactor(const ClientTable& clients, uint8_t current, uint8_t base) {
+        if (!clients.allAcked()) {
+            return base;
+        }
+        if (!clients.allDue()) {
+            return current;
+        }
+
+        int8_t margin = 0;
+        if (!clients.minMarginDb(margin)) {
+            return current;
+        }
+        if (margin >= TARGET_MARGIN_DB + STEP_MARGIN_DB && current > MIN_SPREADING_FACTOR) {
+            return current - 1;
+        }
+        if (margin < TARGET_MARGIN_DB && current < base) {
+            return current + 1;
+        }
+        return current;
+    }
+
+    /**
+     * @brief Computes a client's output power after an ACK that was not confirmed.
+     * @param current The client's current output power.
+     * @param maxPower Output power limit of the cell.
+     * @return The new output power.
+     */
+    static int8_t unconfirmedPower(int8_t current, int8_t maxPower) {
+        return (int8_t)clamp(current + UNCONFIRMED_POWER_STEP, MIN_OUTPUT_POWER, maxPower);
+    }
+
+private:
+    /**
+     * @brief Limits a value to a range.
+     * @param value The value to limit.
+     * @param low The lower bound.
+     * @param high The upper bound.
+     * @return The limited value.
+     */
+    static int clamp(int value, int low, int high) {
+        return value < low ? low : (value > high ? high : value);
+    }
+};
+
+#endif // ADR_ENGINE_H
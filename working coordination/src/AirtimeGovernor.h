@@ -0,0 +1,203 @@
+/**
+ * @file AirtimeGovernor.h
+ * @brief This file contains the AirtimeGovernor class, which keeps the transmit path within a duty-cycle limit per sub-band.
+ */
+
+#ifndef AIRTIME_GOVERNOR_H
+#define AIRTIME_GOVERNOR_H
+
+#include <Arduino.h>
+
+/**
+ * @class AirtimeGovernor
+ * @brief Sliding-window airtime budget per sub-band, checked before every frame goes on air.
+ *
+ * The time on air of each sent frame is added to the bucket of the minute it ended in. A frame
+ * may start if the airtime of the current bucket and the WINDOW_BUCKETS before it, plus its own,
+ * stays within the budget. Those buckets cover every hour that ends now, so no hour can go over
+ * the limit, and the estimate errs by at most one bucket towards waiting too long.
+ *
+ * Low-priority frames, which repeat information the receiver may already have, may only use
+ * LOW_PRIORITY_PERCENT of the budget, so the rest stays available for the frames a cycle cannot
+ * do without. When a frame does not fit, waitUs() says how long until it would; the caller
+ * defers the frame by that much or drops it.
+ *
+ * The class has no constructor so that an instance can be kept in RTC memory
+ * across deep sleep. Call reset() after a normal boot.
+ */
+class AirtimeGovernor {
+public:
+    /**
+     * @enum Priority
+     * @brief Share of the budget a frame may use.
+     */
+    enum Priority {
+        PRIORITY_HIGH, // The whole budget, e.g. the first beacon of a cycle or a confirmation
+        PRIORITY_LOW   // LOW_PRIORITY_PERCENT of the budget, e.g. beacon resends and ACK retries
+    };
+
+    static const uint8_t MAX_BANDS = 2;             // Sub-bands tracked at the same time
+    static const uint8_t WINDOW_BUCKETS = 60;       // Buckets of the window before the current one
+    static const int64_t BUCKET_US = 60000000LL;    // Length of a bucket in microseconds
+    static const int64_t WINDOW_US = WINDOW_BUCKETS * BUCKET_US; // Length of the regulated window, one hour
+    static const uint8_t LOW_PRIORITY_PERCENT = 80; // Share of the budget low-priority frames may use
+    static const int64_t NEVER = INT64_MAX;         // Returned by waitUs() for a frame that can never fit
+
+    /**
+     * @brief Forgets the airtime of every sub-band and sets the limit.
+     * @param dutyCycle Share of any hour a sub-band may be transmitted on, 0 for no limit.
+     */
+    void reset(float dutyCycle) {
+        memset(bands, 0, sizeof(bands));
+        budgetMs = dutyCycle > 0 ? (uint32_t)(dutyCycle * (float)(WINDOW_US / 1000)) : 0;
+    }
+
+    /**
+     * @brief Checks whether a limit is set.
+     * @return True if frames are checked against a budget.
+     */
+    bool isLimited() const { return budgetMs > 0; }
+
+    /**
+     * @brief Getter for the budget.
+     * @return The airtime allowed per sub-band and window in milliseconds, 0 without a limit.
+     */
+    uint32_t getBudgetMs() const { return budgetMs; }
+
+    /**
+     * @brief Computes how long a frame has to wait before it fits into the budget.
+     * @param subBand The sub-band the frame is sent on.
+     * @param timeOnAirUs Time on air of the frame in microseconds.
+     * @param priority Priority of the frame.
+     * @param nowUs Current time in WakeScheduler::nowUs() microseconds.
+     * @return 0 if the frame may be sent now, otherwise the wait in microseconds, NEVER if the
+     *         frame is longer than its share of the budget or no sub-band slot is free.
+     */
+    int64_t waitUs(uint8_t subBand, uint32_t timeOnAirUs, Priority priority, int64_t nowUs) {
+        if (budgetMs == 0) {
+            return 0;
+        }
+        uint32_t shareMs = priority == PRIORITY_HIGH ? budgetMs : (uint32_t)((uint64_t)budgetMs * LOW_PRIORITY_PERCENT / 100);
+        uint32_t neededMs = toMs(timeOnAirUs);
+        Band* band = bandFor(subBand, nowUs);
+        if (band == NULL || neededMs > shareMs) {
+            return NEVER;
+        }
+
+        uint32_t usedMs = sum(*band);
+        if (usedMs + neededMs <= shareMs) {
+            return 0;
+        }
+        // Buckets leave the window oldest first, bucket b once bucket b + WINDOW_BUCKETS + 1 starts
+        for (uint8_t age = WINDOW_BUCKETS; age > 0; --age) {
+            usedMs -= band->usedMs[slotOf(band->bucket - age)];
+            if (usedMs + neededMs <= shareMs) {
+                int64_t freeUs = (int64_t)(band->bucket - age + WINDOW_BUCKETS + 1) * BUCKET_US - nowUs;
+                return freeUs > 0 ? freeUs : 1;
+            }
+        }
+        return (int64_t)(band->bucket + WINDOW_BUCKETS + 1) * BUCKET_US - nowUs; // Only the current bucket is left
+    }
+
+    /**
+     * @brief Adds a frame to the airtime of its sub-band, called once the frame left the radio.
+     * @param subBand The sub-band the frame was sent on.
+     * @param timeOnAirUs Time on air of the frame in microseconds.
+     * @param nowUs End of the frame in WakeScheduler::nowUs() microseconds.
+     */
+    void commit(uint8_t subBand, uint32_t timeOnAirUs, int64_t nowUs) {
+        if (budgetMs == 0) {
+            return;
+        }
+        Band* band = bandFor(subBand, nowUs);
+        if (band == NULL) {
+            return;
+        }
+        uint16_t& usedMs = band->usedMs[slotOf(band->bucket)];
+        uint32_t total = (uint32_t)usedMs + toMs(timeOnAirUs);
+        usedMs = total > 0xFFFF ? 0xFFFF : (uint16_t)total;
+    }
+
+    /**
+     * @brief Getter for the airtime of a sub-band in the window ending now.
+     * @param subBand The sub-band.
+     * @param nowUs Current time in WakeScheduler::nowUs() microseconds.
+     * @return The airtime in milliseconds.
+     */
+    uint32_t getUsedMs(uint8_t subBand, int64_t nowUs) {
+        Band* band = budgetMs == 0 ? NULL : bandFor(subBand, nowUs);
+        return band == NULL ? 0 : sum(*band);
+    }
+
+private:
+    static const uint8_t SLOT_COUNT = WINDOW_BUCKETS + 1; // Buckets kept per sub-band, the window and the current one
+
+    /**
+     * @struct Band
+     * @brief Airtime history of one sub-band.
+     */
+    struct Band {
+        uint32_t bucket;              // Index of the current bucket, nowUs / BUCKET_US
+        uint16_t usedMs[SLOT_COUNT];  // Airtime per bucket in milliseconds, bucket b in slot b % SLOT_COUNT
+        uint8_t subBand;              // Sub-band of the history
+        bool used;                    // True if the slot tracks a sub-band
+    };
+
+    Band bands[MAX_BANDS]; // Tracked sub-bands
+    uint32_t budgetMs;     // Airtime allowed per window, 0 for no limit
+
+    static uint8_t slotOf(uint32_t bucket) { return (uint8_t)(bucket % SLOT_COUNT); }
+
+    static uint32_t toMs(uint32_t timeOnAirUs) { return (timeOnAirUs + 999) / 1000; } // Rounded up, so the budget is never overrun
+
+    static uint32_t sum(const Band& band) {
+        uint32_t total = 0;
+        for (uint8_t i = 0; i < SLOT_COUNT; ++i) {
+            total += band.usedMs[i];
+        }
+        return total;
+    }
+
+    /**
+     * @brief Finds or claims the history of a sub-band and moves it to the current bucket.
+     *
+     * A slot whose window has passed entirely is reused for another sub-band. A clock that
+     * went back keeps the current bucket, so airtime is never forgotten early.
+     * @param subBand The sub-band.
+     * @param nowUs Current time in WakeScheduler::nowUs() microseconds.
+     * @return The history, NULL if every slot holds airtime of another sub-band.
+     */
+    Band* bandFor(uint8_t subBand, int64_t nowUs) {
+        uint32_t bucket = (uint32_t)(nowUs / BUCKET_US);
+        Band* band = NULL;
+        for (uint8_t i = 0; i < MAX_BANDS && band == NULL; ++i) {
+            if (bands[i].used && bands[i].subBand == subBand) {
+                band = &bands[i];
+            }
+        }
+        for (uint8_t i = 0; i < MAX_BANDS && band == NULL; ++i) {
+            if (!bands[i].used || (bucket > bands[i].bucket && bucket - bands[i].bucket >= SLOT_COUNT)) {
+                band = &bands[i];
+                memset(band, 0, sizeof(*band));
+                band->subBand = subBand;
+                band->bucket = bucket;
+                band->used = true;
+            }
+        }
+        if (band == NULL || bucket <= band->bucket) {
+            return band;
+        }
+
+        if (bucket - band->bucket >= SLOT_COUNT) {
+            memset(band->usedMs, 0, sizeof(band->usedMs));
+        } else {
+            for (uint32_t b = band->bucket + 1; b <= bucket; ++b) {
+                band->usedMs[slotOf(b)] = 0;
+            }
+        }
+        band->bucket = bucket;
+        return band;
+    }
+};
+
+#endif // AIRTIME_GOVERNOR_H
@@ -0,0 +1,184 @@
+/**
+ * @file BeaconBatch.h
+ * @brief This file contains the BeaconBatch class, which packs the cell's Timer and the per-node schedules of the client registry into a single beacon frame.
+ */
+
+#ifndef BEACON_BATCH_H
+#define BEACON_BATCH_H
+
+#include <Arduino.h>
+#include "Timer.h"
+#include "ClientTable.h"
+
+/**
+ * @class BeaconBatch
+ * @brief Serializes a beacon that resyncs every node of a cell in one transmission.
+ *
+ * The shared epoch, slot table, data rate and channel are sent once, followed by a compact
+ * (node ID, schedule) entry for every client whose schedule differs from the cell's.
+ * Clients not listed follow the cell's schedule. Without any per-node schedule or slot
+ * assignment the beacon is a plain Timer frame, so a cell that does not use them pays nothing.
+ *
+ * The TDMA window after the beacon starts with join slots, contention slots for nodes the
+ * host does not know yet. Every client due this cycle then gets a slot of its own, in the
+ * order of its ClientTable index, and the slots after those are contention slots for
+ * retries. The beacon lists the node ID of each assigned slot; the slots of a plain Timer
+ * are all join slots.
+ *
+ * Layout (little-endian): the Timer payload with slot fields and a FRAME_TYPE_BATCH header, entry count,
+ * join slot count, assigned slot count, entries of 16-bit node ID and 24-bit packed schedule
+ * (see Timer::packSchedule()), 16-bit node IDs of the assigned slots, checksum.
+ */
+class BeaconBatch {
+public:
+    typedef NextField<Timer::SlotLengthField, 1> CountField;      // Number of entries, after the Timer payload
+    typedef NextField<CountField, 1> JoinSlotsField;              // Contention slots at the start of the window
+    typedef NextField<JoinSlotsField, 1> AssignedSlotsField;      // Slots assigned to registered clients, after the join slots
+    typedef FrameField<0, 2> EntryNodeField;                      // Node ID, relative to the entry
+    typedef NextField<EntryNodeField, 3> EntryScheduleField;      // Packed schedule, relative to the entry
+    typedef FrameField<0, 2> SlotNodeField;                       // Node ID of an assigned slot, relative to the slot
+    typedef FrameField<0, 2> ChecksumField;                       // CRC-16, relative to the end of the slots
+
+    static const size_t ENTRY_SIZE = EntryScheduleField::END;  // Node ID and packed schedule
+    static const size_t SLOT_SIZE = SlotNodeField::END;        // Node ID of an assigned slot
+    static const size_t HEADER_SIZE = AssignedSlotsField::END; // Timer payload, entry count and slot counts
+    static const size_t MAX_SIZE = HEADER_SIZE + ClientTable::MAX_CLIENTS * (ENTRY_SIZE + SLOT_SIZE) + ChecksumField::SIZE; // Every client listed, plus checksum
+    static const size_t MAX_PACKET_SIZE = 255; // Largest LoRa payload
+    static const uint8_t NO_SLOT = 0xFF;       // Slot of a node the beacon assigns none
+
+    /**
+     * @struct SlotPlan
+     * @brief Layout of the TDMA window after a beacon, as seen by one node.
+     */
+    struct SlotPlan {
+        uint8_t joinSlots;     // Contention slots at the start of the window
+        uint8_t assignedSlots; // Slots assigned to registered clients, after the join slots
+        uint8_t ownSlot;       // The node's assigned slot, NO_SLOT if it has none
+
+        /**
+         * @brief Checks whether any node may contend for a slot.
+         * @param slot Index of the slot.
+         * @return True for join and retry slots.
+         */
+        bool isContention(uint8_t slot) const {
+            return slot < joinSlots || slot >= joinSlots + assignedSlots;
+        }
+    };
+
+    /**
+     * @brief Serializes a beacon for the cell.
+     * @param timer The cell's Timer, whose slot count covers the join slots, one slot per due client and the retry slots.
+     * @param clients Registry holding the per-node schedules.
+     * @param joinSlots Number of join slots at the start of the window.
+     * @param data The data array to serialize into, at least MAX_SIZE bytes.
+     * @return The number of bytes written.
+     */
+    static size_t serialize(const Timer& timer, const ClientTable& clients, uint8_t joinSlots, uint8_t* data) {
+        size_t length = HEADER_SIZE;
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < ClientTable::MAX_CLIENTS; ++i) {
+            const ClientTable::Entry& entry = clients.at(i);
+            if (!entry.used || entry.messageInterval == 0) {
+                continue;
+            }
+            EntryNodeField::write(data + length, entry.nodeId);
+            EntryScheduleField::write(data + length, Timer::packSchedule(entry.messageInterval, entry.waitTime, entry.sleepState));
+            length += ENTRY_SIZE;
+            count++;
+        }
+
+        uint8_t assigned = 0;
+        for (uint8_t i = 0; i < ClientTable::MAX_CLIENTS; ++i) {
+            if (!clients.isDue(i)) {
+                continue;
+            }
+            SlotNodeField::write(data + length, clients.at(i).nodeId);
+            length += SLOT_SIZE;
+            assigned++;
+        }
+
+        if (count == 0 && assigned == 0) {
+            return timer.serialize(data); // Every node follows the cell's schedule and contends for a slot
+        }
+
+        timer.writePayload(data, Timer::FRAME_TYPE_BATCH, true);
+        CountField::write(data, count);
+        JoinSlotsField::write(data, joinSlots);
+        AssignedSlotsField::write(data, assigned);
+        ChecksumField::write(data + length, Timer::calculateChecksum(data, length));
+        return length + ChecksumField::SIZE;
+    }
+
+    /**
+     * @brief Deserializes a beacon into the schedule and slots of one node.
+     * @param data The received frame, a Timer or a batched beacon.
+     * @param length The length of the received frame.
+     * @param nodeId Identifier of the receiving node.
+     * @param timer Set to the cell's Timer with the node's own schedule applied.
+     * @param slots Set to the layout of the slot window and the node's own slot.
+     * @return True if the frame is a valid beacon.
+     */
+    static bool deserialize(const uint8_t* data, size_t length, uint16_t nodeId, Timer& timer, SlotPlan& slots) {
+        if (length > 0 && Timer::headerType(Timer::HeaderField::read(data)) == Timer::FRAME_TYPE_SYNC) {
+            if (!timer.deserialize(data, length)) {
+                return false;
+            }
+            slots.joinSlots = timer.getSlotCount(); // Nobody is assigned a slot
+            slots.assignedSlots = 0;
+            slots.ownSlot = NO_SLOT;
+            return true;
+        }
+        if (length < HEADER_SIZE + ChecksumField::SIZE || Timer::HeaderField::read(data) != Timer::makeHeader(Timer::FRAME_TYPE_BATCH, true)) {
+            return false; // Too short, or not a batched beacon of this version
+        }
+        uint8_t count = CountField::read(data);
+        uint8_t assigned = AssignedSlotsField::read(data);
+        size_t slotsOffset = HEADER_SIZE + (size_t)count * ENTRY_SIZE;
+        if (length != slotsOffset + (size_t)assigned * SLOT_SIZE + ChecksumField::SIZE ||
+            readChecksum(data, length) != Timer::calculateChecksum(data, length - ChecksumField::SIZE)) {
+            return false; // Truncated or corrupted
+        }
+
+        timer.readPayload(data);
+        slots.joinSlots = JoinSlotsField::read(data);
+        slots.assignedSlots = assigned;
+        slots.ownSlot = NO_SLOT;
+        if ((uint16_t)slots.joinSlots + assigned > timer.getSlotCount()) {
+            return false; // Assigned slots beyond the window
+        }
+
+        for (uint8_t i = 0; i < count; ++i) {
+            const uint8_t* entry = data + HEADER_SIZE + (size_t)i * ENTRY_SIZE;
+            if (EntryNodeField::read(entry) != nodeId) {
+                continue;
+            }
+            uint16_t messageInterval = 0;
+            uint16_t waitTime = 0;
+            uint8_t sleepState = 0;
+            Timer::unpackSchedule(EntryScheduleField::read(entry), messageInterval, waitTime, sleepState);
+            timer = Timer(timer.getCurrentTime(), messageInterval, waitTime, sleepState, timer.getSlotCount(), timer.getSlotLength(), timer.getSpreadingFactor(), timer.getChannel());
+            break;
+        }
+        for (uint8_t i = 0; i < assigned; ++i) {
+            if (SlotNodeField::read(data + slotsOffset + (size_t)i * SLOT_SIZE) == nodeId) {
+                slots.ownSlot = (uint8_t)(slots.joinSlots + i);
+                break;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Reads the checksum of a beacon, which is carried in its last two bytes.
+     * @param data The frame.
+     * @param length The length of the frame, at least ChecksumField::SIZE.
+     * @return The stored checksum.
+     */
+    static uint16_t readChecksum(const uint8_t* data, size_t length) {
+        return (uint16_t)ChecksumField::read(data + length - ChecksumField::SIZE);
+    }
+};
+
+static_assert(BeaconBatch::MAX_SIZE <= BeaconBatch::MAX_PACKET_SIZE, "A beacon listing every client must fit one LoRa packet");
+
+#endif // BEACON_BATCH_H
@@ -0,0 +1,129 @@
+/**
+ * @file ChannelPlan.h
+ * @brief This file contains the ChannelPlan structure, which divides a band into per-cell sub-bands and derives the channel hop sequence of a cell.
+ */
+
+#ifndef CHANNEL_PLAN_H
+#define CHANNEL_PLAN_H
+
+#include <Arduino.h>
+#include "ClientTable.h"
+#include "Timer.h"
+
+/**
+ * @struct ChannelPlan
+ * @brief Channel grid of the band and the sub-band a cell hops in, kept as plain data so it can live in RTC memory.
+ *
+ * Channels are numbered across the whole band, channel 0 at baseFrequency. Sub-band k holds
+ * channels k * subBandSize to (k + 1) * subBandSize - 1, and neighbouring cells are given
+ * different sub-bands so their traffic never shares a channel. The first channel of a cell's
+ * sub-band is its home channel, where the cell forms and where lost clients wait.
+ *
+ * The host picks the channel of each cycle from a pseudo-random sequence seeded with the
+ * epoch of the cycle's beacon and announces it in that beacon. Host and clients then switch
+ * together at the end of the cycle, the same way the spreading factor is changed. The beacon
+ * carries the channel as its position in the sub-band, so a sub-band holds at most
+ * MAX_SUB_BAND_SIZE channels.
+ *
+ * The sub-band must lie within one regulatory sub-band, whose duty-cycle limit it carries.
+ */
+struct ChannelPlan {
+    static const uint8_t MAX_SUB_BAND_SIZE = Timer::CHANNEL_UNCHANGED; // Channel positions a beacon can announce
+    static const uint8_t NO_CHANNEL = 0xFF;                            // Channel number outside every sub-band
+
+    float baseFrequency; // Centre frequency of channel 0 in MHz
+    float spacing;       // Distance between neighbouring channels in MHz
+    uint8_t subBandSize; // Channels in each sub-band, 1 to stay on the home channel, at most MAX_SUB_BAND_SIZE
+    uint8_t subBand;     // Sub-band of this cell
+    float dutyCycle;     // Share of any hour a node may transmit in the sub-band, 0 for no limit (see AirtimeGovernor)
+
+    /**
+     * @brief Getter for the home channel of the cell.
+     * @return The first channel of the cell's sub-band.
+     */
+    uint8_t homeChannel() const { return (uint8_t)(subBand * subBandSize); }
+
+    /**
+     * @brief Computes the centre frequency of a channel.
+     * @param channel The channel number.
+     * @return The frequency in MHz.
+     */
+    float frequencyOf(uint8_t channel) const { return baseFrequency + spacing * channel; }
+
+    /**
+     * @brief Checks whether a channel belongs to the cell's sub-band.
+     * @param channel The channel number.
+     * @return True if the cell may use the channel.
+     */
+    bool contains(uint8_t channel) const {
+        return channel >= homeChannel() && channel < homeChannel() + subBandSize;
+    }
+
+    /**
+     * @brief Converts a channel into its position in the cell's sub-band, as the beacon carries it.
+     * @param channel The channel number.
+     * @return The position, Timer::CHANNEL_UNCHANGED if the channel is outside the sub-band.
+     */
+    uint8_t positionOf(uint8_t channel) const {
+        return contains(channel) && channel - homeChannel() < MAX_SUB_BAND_SIZE ? (uint8_t)(channel - homeChannel()) : Timer::CHANNEL_UNCHANGED;
+    }
+
+    /**
+     * @brief Converts a position in the cell's sub-band, as the beacon carries it, into a channel.
+     * @param position The position, Timer::CHANNEL_UNCHANGED to keep the current channel.
+     * @return The channel number, NO_CHANNEL if the position is outside the sub-band.
+     */
+    uint8_t channelAt(uint8_t position) const {
+        return position < subBandSize && position < MAX_SUB_BAND_SIZE ? (uint8_t)(homeChannel() + position) : NO_CHANNEL;
+    }
+
+    /**
+     * @brief Picks the channel of the hop sequence for a beacon epoch.
+     * @param epoch The epoch seconds of the beacon.
+     * @return A channel of the cell's sub-band.
+     */
+    uint8_t hopChannel(uint32_t epoch) const {
+        if (subBandSize <= 1) {
+            return homeChannel();
+        }
+        return (uint8_t)(homeChannel() + mix(epoch) % subBandSize);
+    }
+
+    /**
+     * @brief Chooses the channel for the next cycle.
+     *
+     * A registered client that did not answer may have missed the last channel change and
+     * waits on the home channel, so any miss sends the cell home. While a client sleeps through
+     * the next cycle the channel is held, since it would not hear the change.
+     * @param clients Client table as the finished cycle left it.
+     * @param current Channel of the finished cycle.
+     * @param epoch The epoch seconds of the first beacon of the next cycle.
+     * @return The channel for the next cycle.
+     */
+    uint8_t nextChannel(const ClientTable& clients, uint8_t current, uint32_t epoch) const {
+        if (!clients.allAcked()) {
+            return homeChannel();
+        }
+        if (!clients.allDue()) {
+            return current;
+        }
+        return hopChannel(epoch);
+    }
+
+private:
+    /**
+     * @brief Scrambles an epoch with the MurmurHash3 finalizer, so consecutive seconds give unrelated channels.
+     * @param value The epoch seconds.
+     * @return The scrambled value.
+     */
+    static uint32_t mix(uint32_t value) {
+        value ^= value >> 16;
+        value *= 0x85EBCA6Bu;
+        value ^= value >> 13;
+        value *= 0xC2B2AE35u;
+        value ^= value >> 16;
+        return value;
+    }
+};
+
+#endif // CHANNEL_PLAN_H
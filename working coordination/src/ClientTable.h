@@ -0,0 +1,263 @@
+/**
+ * @file ClientTable.h
+ * @brief This file contains the ClientTable class, a fixed-size registry the host uses to track the clients of its cell.
+ */
+
+#ifndef CLIENT_TABLE_H
+#define CLIENT_TABLE_H
+
+#include <Arduino.h>
+
+/**
+ * @class ClientTable
+ * @brief Tracks which clients acknowledged the current cycle and drops clients that stopped answering.
+ *
+ * A client may be given its own schedule, which the host announces in its batched beacon.
+ * A client whose interval spans several cycles of the cell is only expected in the cycles
+ * it wakes for, so its sleeping cycles neither count as misses nor hold up allAcked().
+ *
+ * The class has no constructor so that an instance can be kept in RTC memory
+ * across deep sleep. Call reset() after a normal boot.
+ */
+class ClientTable {
+public:
+    static const uint8_t MAX_CLIENTS = 32;       // Capacity of the table
+    static const uint8_t MAX_MISSED_CYCLES = 8;  // Clients missing this many cycles in a row are removed
+
+    /**
+     * @struct Entry
+     * @brief Per-client state.
+     */
+    struct Entry {
+        uint16_t nodeId;        // Identifier of the client
+        uint16_t lastChecksum;  // Checksum of the last Timer the client acknowledged
+        uint8_t missedCycles;   // Consecutive cycles without an ACK
+        bool used;              // True if the entry holds a client
+        bool acked;             // True if the client acknowledged the current cycle
+        bool hasMargin;         // True once marginDb holds a measurement
+        int8_t marginDb;        // Smoothed uplink margin above the demodulation floor, normalized to full power
+        int8_t txPower;         // Output power commanded to the client in dBm
+        uint16_t messageInterval; // Message interval of the client's own schedule, 0 to follow the cell
+        uint8_t waitTime;       // Wait time of the client's own schedule
+        uint8_t sleepState;     // Sleep state of the client's own schedule
+        uint8_t skipCycles;     // Cycles of the cell the client sleeps through before it is due again
+        uint8_t battery;        // Charge the client last reported in percent, PowerPolicy::BATTERY_UNKNOWN if none
+        uint8_t powerLevel;     // Power-saving level derived from the battery, see PowerPolicy
+    };
+
+    /**
+     * @brief Removes all clients.
+     */
+    void reset() {
+        memset(entries, 0, sizeof(entries));
+    }
+
+    /**
+     * @brief Starts a new cycle by clearing every client's acknowledgement.
+     */
+    void beginCycle() {
+        for (uint8_t i = 0; i < MAX_CLIENTS; ++i) {
+            entries[i].acked = false;
+        }
+    }
+
+    /**
+     * @brief Ends the cycle, counting a miss for every silent client and removing stale ones.
+     */
+    void endCycle() {
+        for (uint8_t i = 0; i < MAX_CLIENTS; ++i) {
+            Entry& entry = entries[i];
+            if (!entry.used || entry.acked) {
+                continue;
+            }
+            if (entry.skipCycles > 0) {
+                entry.skipCycles--; // The client was not due this cycle
+                continue;
+            }
+            if (++entry.missedCycles >= MAX_MISSED_CYCLES) {
+                memset(&entry, 0, sizeof(entry));
+            }
+        }
+    }
+
+    /**
+     * @brief Looks up a client.
+     * @param nodeId Identifier of the client.
+     * @return The client's entry, or NULL if it is not registered.
+     */
+    Entry* find(uint16_t nodeId) {
+        for (uint8_t i = 0; i < MAX_CLIENTS; ++i) {
+            if (entries[i].used && entries[i].nodeId == nodeId) {
+                return &entries[i];
+            }
+        }
+        return NULL;
+    }
+
+    /**
+     * @brief Looks up a client, registering it if it is new.
+     * @param nodeId Identifier of the client.
+     * @return The client's entry, or NULL if the table is full.
+     */
+    Entry* findOrAdd(uint16_t nodeId) {
+        Entry* entry = find(nodeId);
+        for (uint8_t i = 0; i < MAX_CLIENTS && entry == NULL; ++i) {
+            if (!entries[i].used) {
+                entry = &entries[i];
+                memset(entry, 0, sizeof(*entry));
+                entry->used = true;
+                entry->nodeId = nodeId;
+                entry->battery = 0xFF; // PowerPolicy::BATTERY_UNKNOWN until the client reports it
+            }
+        }
+        return entry;
+    }
+
+    /**
+     * @brief Records an acknowledgement, registering the client if it is new.
+     * @param nodeId Identifier of the client.
+     * @param checksum Checksum of the acknowledged Timer.
+     * @param cellInterval Message interval of the cell, used to find when the client is due again.
+     * @return The client's entry, or NULL if the table is full.
+     */
+    Entry* markAcked(uint16_t nodeId, uint16_t checksum, uint16_t cellInterval) {
+        Entry* entry = findOrAdd(nodeId);
+        if (entry == NULL) {
+            return NULL; // Table full
+        }
+
+        entry->lastChecksum = checksum;
+        entry->missedCycles = 0;
+        entry->acked = true;
+        uint16_t cycles = (cellInterval > 0 && entry->messageInterval > cellInterval) ? entry->messageInterval / cellInterval : 1;
+        entry->skipCycles = cycles > 0xFF ? 0xFF : (uint8_t)(cycles - 1);
+        return entry;
+    }
+
+    /**
+     * @brief Gives a client its own schedule, registering the client if it is new.
+     *
+     * The interval should be a multiple of the cell's interval, so the client wakes
+     * for one of the host's cycles. A client that stops answering is removed together
+     * with its schedule after MAX_MISSED_CYCLES of the cycles it was due for.
+     * @param nodeId Identifier of the client.
+     * @param messageInterval The client's message interval, 0 to follow the cell again.
+     * @param waitTime The client's wait time.
+     * @param sleepState The client's sleep state.
+     * @return The client's entry, or NULL if the table is full.
+     */
+    Entry* setSchedule(uint16_t nodeId, uint16_t messageInterval, uint8_t waitTime, uint8_t sleepState) {
+        Entry* entry = findOrAdd(nodeId);
+        if (entry != NULL) {
+            entry->messageInterval = messageInterval;
+            entry->waitTime = waitTime;
+            entry->sleepState = sleepState;
+        }
+        return entry;
+    }
+
+    /**
+     * @brief Accessor for an entry by position, for iterating over the table.
+     * @param index Position in the table, below MAX_CLIENTS.
+     * @return The entry, unused if its used flag is false.
+     */
+    const Entry& at(uint8_t index) const {
+        return entries[index];
+    }
+
+    /**
+     * @brief Counts the registered clients.
+     * @return The number of clients in the table.
+     */
+    uint8_t size() const {
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < MAX_CLIENTS; ++i) {
+            if (entries[i].used) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * @brief Counts the clients expected in the current cycle.
+     * @return The number of clients that acknowledged or are not sleeping through the cycle.
+     */
+    uint8_t dueCount() const {
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < MAX_CLIENTS; ++i) {
+            if (isDue(i)) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * @brief Checks whether the client at an index is expected in the current cycle.
+     * @param index Index into the table, below MAX_CLIENTS.
+     * @return True if the entry is used and acknowledged or not sleeping through the cycle.
+     */
+    bool isDue(uint8_t index) const {
+        const Entry& entry = entries[index];
+        return entry.used && (entry.acked || entry.skipCycles == 0);
+    }
+
+    /**
+     * @brief Checks whether every registered client wakes for the next cycle.
+     * @return True if no client sleeps through the next cycle.
+     */
+    bool allDue() const {
+        for (uint8_t i = 0; i < MAX_CLIENTS; ++i) {
+            if (entries[i].used && entries[i].skipCycles > 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Counts the clients that acknowledged the current cycle.
+     * @return The number of acknowledged clients.
+     */
+    uint8_t ackedCount() const {
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < MAX_CLIENTS; ++i) {
+            if (entries[i].used && entries[i].acked) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * @brief Finds the weakest link among the clients that acknowledged the current cycle.
+     * @param marginDb Set to the smallest link margin in dB.
+     * @return True if at least one acknowledged client has a margin measurement.
+     */
+    bool minMarginDb(int8_t& marginDb) const {
+        bool found = false;
+        for (uint8_t i = 0; i < MAX_CLIENTS; ++i) {
+            const Entry& entry = entries[i];
+            if (entry.used && entry.acked && entry.hasMargin && (!found || entry.marginDb < marginDb)) {
+                marginDb = entry.marginDb;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    /**
+     * @brief Checks whether every client expected in the current cycle acknowledged it.
+     * @return True if at least one client is due and all due clients acknowledged.
+     */
+    bool allAcked() const {
+        uint8_t due = dueCount();
+        return due > 0 && ackedCount() == due;
+    }
+
+private:
+    Entry entries[MAX_CLIENTS]; // Client entries, unused ones are zeroed
+};
+
+#endif // CLIENT_TABLE_H
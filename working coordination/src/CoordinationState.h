@@ -0,0 +1,126 @@
+/**
+ * @file CoordinationState.h
+ * @brief This file contains the CoordinationState class, which bundles everything a node must remember across deep sleep to rejoin its cell without a full re-sync.
+ */
+
+#ifndef COORDINATION_STATE_H
+#define COORDINATION_STATE_H
+
+#include <Arduino.h>
+#include "Timer.h"
+#include "WakeScheduler.h"
+#include "ClientTable.h"
+#include "RadioConfig.h"
+#include "ChannelPlan.h"
+#include "CycleTrace.h"
+#include "LinkMetrics.h"
+#include "AirtimeGovernor.h"
+
+/**
+ * @class CoordinationState
+ * @brief Schedule, drift estimate, client registry, radio settings, channel, airtime budget, cycle trace and link metrics of a node.
+ *
+ * The class has no constructor so that an instance can be kept in RTC memory
+ * across deep sleep. Call reset() after a normal boot. The schedule is stored
+ * in its serialized form because Timer has constructors, which would run again
+ * on every wake and overwrite RTC data.
+ */
+class CoordinationState {
+public:
+    static const uint32_t MAGIC = 0x57414B45; // Marks a state written by this firmware ("WAKE")
+    static const uint8_t MAX_MISSED_WARM_WINDOWS = 3; // Missed warm listen windows before falling back to discovery
+
+    WakeScheduler scheduler; // Sync point and drift estimate
+    ClientTable clients;     // Host-side client registry
+    RadioConfig radio;       // Radio settings the node runs with
+    uint8_t missedWarmWindows; // Consecutive warm wakes without a beacon
+    uint8_t baseSpreadingFactor; // Spreading factor the cell starts and falls back to
+    int8_t maxOutputPower;     // Output power limit for adaptive power control
+    uint8_t powerLevel;        // Power-saving level of this node's own battery, see PowerPolicy
+    ChannelPlan channels;      // Channel grid and sub-band of the cell
+    uint8_t channel;           // Channel the radio is tuned to
+    AirtimeGovernor airtime;   // Airtime sent in the last hour, against the duty-cycle limit of the plan
+    CycleTrace trace;          // Phase timings of the recent cycles
+    LinkMetrics metrics;       // Link-quality and airtime counters since the last normal boot
+
+    /**
+     * @brief Clears the state after a normal boot.
+     *
+     * The radio starts on the home channel of the plan, whatever frequency radioConfig holds.
+     * @param radioConfig The radio settings to start with.
+     * @param channelPlan The channels of the cell.
+     */
+    void reset(const RadioConfig& radioConfig, const ChannelPlan& channelPlan) {
+        scheduler.reset();
+        clients.reset();
+        radio = radioConfig;
+        channels = channelPlan;
+        channel = channelPlan.homeChannel();
+        radio.frequency = channelPlan.frequencyOf(channel);
+        airtime.reset(channelPlan.dutyCycle);
+        missedWarmWindows = 0;
+        baseSpreadingFactor = radioConfig.spreadingFactor;
+        maxOutputPower = radioConfig.outputPower;
+        powerLevel = 0;
+        trace.reset();
+        metrics.reset();
+        radioHash = 0;
+        memset(schedule, 0, sizeof(schedule));
+        magic = MAGIC;
+    }
+
+    /**
+     * @brief Checks whether the state was written by this firmware.
+     * @return True if reset() has run since the RTC memory was last lost.
+     */
+    bool isValid() const {
+        return magic == MAGIC;
+    }
+
+    /**
+     * @brief Checks whether the state holds a schedule the node can wake into.
+     * @return True if a previous cycle completed a sync since the last normal boot.
+     */
+    bool isWarm() const {
+        return isValid() && scheduler.isSynchronized() && getSchedule().getMessageInterval() > 0;
+    }
+
+    /**
+     * @brief Checks whether the radio kept the current settings through deep sleep.
+     * @return True if the radio entered warm sleep with settings matching the stored ones.
+     */
+    bool isRadioRetained() const {
+        return isValid() && radioHash != 0 && radioHash == radio.hash();
+    }
+
+    /**
+     * @brief Records whether the radio enters deep sleep with its configuration retained.
+     * @param retained True if the radio was put into warm sleep.
+     */
+    void setRadioRetained(bool retained) {
+        radioHash = retained ? radio.hash() : 0;
+    }
+
+    /**
+     * @brief Getter for the last schedule.
+     * @return The last schedule, all zero if none was stored.
+     */
+    Timer getSchedule() const {
+        return Timer(schedule, sizeof(schedule));
+    }
+
+    /**
+     * @brief Stores the schedule of the current cycle.
+     * @param timer The schedule to store.
+     */
+    void setSchedule(const Timer& timer) {
+        timer.serialize(schedule);
+    }
+
+private:
+    uint32_t magic;                             // MAGIC once reset() has run
+    uint32_t radioHash;                         // Hash of the settings retained by the sleeping radio, 0 if none
+    uint8_t schedule[Timer::SERIALIZED_SIZE];   // Last schedule in serialized form
+};
+
+#endif // COORDINATION_STATE_H
@@ -0,0 +1,186 @@
+/**
+ * @file CycleTrace.h
+ * @brief This file contains the CycleTrace class, which records how long each phase of a coordination cycle keeps the node awake.
+ */
+
+#ifndef CYCLE_TRACE_H
+#define CYCLE_TRACE_H
+
+#include <Arduino.h>
+
+/**
+ * @class CycleTrace
+ * @brief Phase timings of the last cycles and per-phase duration histograms.
+ *
+ * Recording a phase only stores a few words, so it can run in the radio path; the
+ * text output is left to dump(), which the owner calls when blocking is harmless.
+ * The last RING_SIZE phases are kept with their timestamps; every phase ever recorded
+ * since reset() also lands in a histogram with power-of-two microsecond buckets.
+ *
+ * The class has no constructor so that an instance can be kept in RTC memory
+ * across deep sleep. Call reset() after a normal boot. Recording is safe from both cores.
+ */
+class CycleTrace {
+public:
+    /**
+     * @enum Phase
+     * @brief Traced phases of a cycle.
+     */
+    enum Phase {
+        PHASE_BOOT,        // Reset until setup() runs
+        PHASE_RADIO_INIT,  // Radio warm start or full initialization
+        PHASE_BEACON_WAIT, // Client listening for a beacon
+        PHASE_TX,          // A frame on air, also counted in the phase it belongs to
+        PHASE_ACK,         // Client ACK exchange, or a host listening for ACKs
+        PHASE_DISPLAY,     // Drawing one display event
+        PHASE_COUNT        // Number of phases
+    };
+
+    static const uint8_t RING_SIZE = 32;    // Phase records kept
+    static const uint8_t BUCKET_COUNT = 24; // Histogram buckets, the last one collects everything from 2^23 us (8.4 s)
+
+    /**
+     * @struct Record
+     * @brief One traced phase.
+     */
+    struct Record {
+        uint32_t cycle;      // Cycle the phase belongs to
+        uint32_t startUs;    // Start of the phase, microseconds since the cycle's boot
+        uint32_t durationUs; // Length of the phase in microseconds
+        uint8_t phase;       // One of the Phase values
+    };
+
+    /**
+     * @brief Clears all records and histograms.
+     */
+    void reset() {
+        memset(this, 0, sizeof(*this));
+    }
+
+    /**
+     * @brief Starts a new cycle, called once per wake.
+     */
+    void beginCycle() {
+        cycle++;
+    }
+
+    /**
+     * @brief Getter for the cycle counter.
+     * @return The number of cycles since reset().
+     */
+    uint32_t getCycle() const { return cycle; }
+
+    /**
+     * @brief Records a phase.
+     * @param phase The phase.
+     * @param startUs Start of the phase from esp_timer_get_time().
+     * @param endUs End of the phase from esp_timer_get_time().
+     */
+    void record(Phase phase, int64_t startUs, int64_t endUs) {
+        uint32_t durationUs = endUs > startUs ? (uint32_t)(endUs - startUs) : 0;
+        uint8_t bucket = bucketFor(durationUs);
+
+        portENTER_CRITICAL(&lock());
+        Record& entry = ring[head];
+        entry.cycle = cycle;
+        entry.startUs = (uint32_t)startUs;
+        entry.durationUs = durationUs;
+        entry.phase = (uint8_t)phase;
+        head = (uint8_t)((head + 1) % RING_SIZE);
+        if (count < RING_SIZE) {
+            count++;
+        }
+        if (histogram[phase][bucket] < 0xFFFF) {
+            histogram[phase][bucket]++;
+        }
+        totalUs[phase] += durationUs;
+        samples[phase]++;
+        portEXIT_CRITICAL(&lock());
+    }
+
+    /**
+     * @brief Records a phase that ends now.
+     * @param phase The phase.
+     * @param startUs Start of the phase from esp_timer_get_time().
+     */
+    void recordSince(Phase phase, int64_t startUs) {
+        record(phase, startUs, esp_timer_get_time());
+    }
+
+    /**
+     * @brief Prints the kept records and one histogram line per phase.
+     *
+     * Blocks while the text is written, so call it outside the radio path.
+     * @param out The output, e.g. Serial.
+     */
+    void dump(Print& out) const {
+        char line[96];
+        uint8_t first = (uint8_t)((head + RING_SIZE - count) % RING_SIZE);
+        for (uint8_t i = 0; i < count; ++i) {
+            const Record& entry = ring[(first + i) % RING_SIZE];
+            snprintf(line, sizeof(line), "trace %lu %s +%lu us %lu us",
+                     (unsigned long)entry.cycle, phaseName(entry.phase), (unsigned long)entry.startUs, (unsigned long)entry.durationUs);
+            out.println(line);
+        }
+
+        for (uint8_t phase = 0; phase < PHASE_COUNT; ++phase) {
+            if (samples[phase] == 0) {
+                continue;
+            }
+            snprintf(line, sizeof(line), "hist %s n=%lu mean=%lu us 2^i:",
+                     phaseName(phase), (unsigned long)samples[phase], (unsigned long)(totalUs[phase] / samples[phase]));
+            out.print(line);
+            for (uint8_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+                if (histogram[phase][bucket] != 0) {
+                    snprintf(line, sizeof(line), " %u=%u", (unsigned int)bucket, (unsigned int)histogram[phase][bucket]);
+                    out.print(line);
+                }
+            }
+            out.println();
+        }
+    }
+
+    /**
+     * @brief Returns the short name of a phase used by dump().
+     * @param phase One of the Phase values.
+     * @return The name.
+     */
+    static const char* phaseName(uint8_t phase) {
+        static const char* const NAMES[PHASE_COUNT] = {"boot", "radio_init", "beacon_wait", "tx", "ack", "display"};
+        return phase < PHASE_COUNT ? NAMES[phase] : "?";
+    }
+
+private:
+    uint32_t cycle;                                  // Cycles since reset()
+    uint8_t head;                                    // Next ring slot to write
+    uint8_t count;                                   // Valid ring slots
+    Record ring[RING_SIZE];                          // Last phases, oldest overwritten first
+    uint16_t histogram[PHASE_COUNT][BUCKET_COUNT];   // Durations per phase, bucket i counts [2^i, 2^(i+1)) us
+    uint64_t totalUs[PHASE_COUNT];                   // Sum of the durations per phase
+    uint32_t samples[PHASE_COUNT];                   // Recorded phases per phase
+
+    /**
+     * @brief Maps a duration onto its histogram bucket.
+     * @param durationUs The duration in microseconds.
+     * @return floor(log2(durationUs)), limited to the last bucket.
+     */
+    static uint8_t bucketFor(uint32_t durationUs) {
+        uint8_t bucket = 0;
+        while (durationUs > 1 && bucket < BUCKET_COUNT - 1) {
+            durationUs >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    /**
+     * @brief Spinlock shared by both cores, kept out of RTC memory.
+     * @return The lock.
+     */
+    static portMUX_TYPE& lock() {
+        static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+        return mux;
+    }
+};
+
+#endif // CYCLE_TRACE_H
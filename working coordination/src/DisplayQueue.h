@@ -0,0 +1,101 @@
+#ifndef DISPLAY_QUEUE_H // Prevents multiple inclusions of this header file
+#define DISPLAY_QUEUE_H
+
+#include <Arduino.h> // Includes the Arduino core library
+
+// DisplayQueue class definition
+// Bounded FreeRTOS queue of fixed-size display events between the task that owns the
+// radio and the task that owns the OLED. Posting never blocks: when the display falls
+// behind, new events are dropped and counted, so a slow I2C refresh cannot delay the radio.
+class DisplayQueue {
+public:
+    static const uint8_t MAX_LINES = 4; // Text lines per event
+    static const size_t LINE_LENGTH = 32; // Characters per line, including the terminator
+    static const UBaseType_t DEPTH = 8; // Events the queue holds
+
+    static const uint8_t EVENT_TEXT = 0; // Clear the display and draw the lines
+    static const uint8_t EVENT_CLEAR = 1; // Clear the display
+    static const uint8_t EVENT_POWER_OFF = 2; // Turn the display off and notify the sender
+
+    // Fixed-size event copied through the queue
+    struct Event {
+        uint8_t type; // One of the EVENT_ constants
+        uint8_t lineCount; // Lines used for EVENT_TEXT
+        TaskHandle_t notify; // Task to notify once the event was handled, NULL for none
+        char lines[MAX_LINES][LINE_LENGTH]; // Text lines, truncated to fit
+    };
+
+    // Constructor, call begin() before posting
+    DisplayQueue() : queue(NULL), dropped(0) {}
+
+    // Creates the queue and returns false if it could not be allocated
+    bool begin() {
+        queue = xQueueCreate(DEPTH, sizeof(Event));
+        return queue != NULL;
+    }
+
+    // Posts up to four lines of text, returns false if the event was dropped
+    bool postText(const char* line1, const char* line2 = NULL, const char* line3 = NULL, const char* line4 = NULL) {
+        Event event;
+        memset(&event, 0, sizeof(event));
+        event.type = EVENT_TEXT;
+        const char* lines[MAX_LINES] = {line1, line2, line3, line4};
+        for (uint8_t i = 0; i < MAX_LINES && lines[i] != NULL; ++i) {
+            strncpy(event.lines[i], lines[i], LINE_LENGTH - 1);
+            event.lineCount = i + 1;
+        }
+        return post(event);
+    }
+
+    // Posts a request to clear the display, returns false if the event was dropped
+    bool postClear() {
+        Event event;
+        memset(&event, 0, sizeof(event));
+        event.type = EVENT_CLEAR;
+        return post(event);
+    }
+
+    // Asks the display task to turn the display off and waits until it did
+    // Uses the calling task's notification, so pending notifications are discarded first
+    bool powerOff(TickType_t timeout) {
+        Event event;
+        memset(&event, 0, sizeof(event));
+        event.type = EVENT_POWER_OFF;
+        event.notify = xTaskGetCurrentTaskHandle();
+        ulTaskNotifyTake(pdTRUE, 0);
+        if (queue == NULL || xQueueSend(queue, &event, timeout) != pdTRUE) {
+            return false;
+        }
+        return ulTaskNotifyTake(pdTRUE, timeout) != 0;
+    }
+
+    // Waits for the next event, returns false on timeout
+    bool receive(Event& event, TickType_t wait) {
+        return queue != NULL && xQueueReceive(queue, &event, wait) == pdTRUE;
+    }
+
+    // Tells the sender of an event that it was handled
+    static void acknowledge(const Event& event) {
+        if (event.notify != NULL) {
+            xTaskNotifyGive(event.notify);
+        }
+    }
+
+    // Getter for the number of events dropped because the queue was full
+    uint32_t getDropped() const { return dropped; }
+
+private:
+    QueueHandle_t queue; // FreeRTOS queue of Event
+    volatile uint32_t dropped; // Events dropped so far
+
+    // Queues an event without waiting
+    bool post(const Event& event) {
+        if (queue == NULL || xQueueSend(queue, &event, 0) != pdTRUE) {
+            dropped = dropped + 1;
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif // DISPLAY_QUEUE_H
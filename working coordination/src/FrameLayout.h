@@ -0,0 +1,74 @@
+/**
+ * @file FrameLayout.h
+ * @brief This file contains compile-time descriptions of little-endian frame fields, from which frame offsets, sizes and the serialization code are generated.
+ */
+
+#ifndef FRAME_LAYOUT_H
+#define FRAME_LAYOUT_H
+
+#include <Arduino.h>
+
+/**
+ * @struct FrameBytes
+ * @brief Byte-wise little-endian access to N bytes, unrolled by the compiler.
+ */
+template <size_t N>
+struct FrameBytes {
+    static void write(uint8_t* data, uint32_t value) {
+        data[0] = (uint8_t)value;
+        FrameBytes<N - 1>::write(data + 1, value >> 8);
+    }
+    static uint32_t read(const uint8_t* data) {
+        return (uint32_t)data[0] | (FrameBytes<N - 1>::read(data + 1) << 8);
+    }
+};
+
+/**
+ * @brief End of the FrameBytes recursion.
+ */
+template <>
+struct FrameBytes<0> {
+    static void write(uint8_t*, uint32_t) {}
+    static uint32_t read(const uint8_t*) { return 0; }
+};
+
+/**
+ * @struct FrameField
+ * @brief A field of Size bytes (1 to 4) at a fixed offset.
+ *
+ * A frame is declared as a chain of fields: the first one is a FrameField at offset 0
+ * and every following one a NextField of its predecessor, so offsets follow from the
+ * sizes and the frame size is the END of its last field. read() and write() compile to
+ * one load or store per byte at constant offsets.
+ */
+template <size_t Offset, size_t Size>
+struct FrameField {
+    static_assert(Size >= 1 && Size <= 4, "A frame field holds 1 to 4 bytes");
+
+    static const size_t OFFSET = Offset;     // First byte of the field
+    static const size_t SIZE = Size;         // Bytes in the field
+    static const size_t END = Offset + Size; // First byte after the field
+
+    /**
+     * @brief Stores the low Size bytes of a value.
+     * @param data The frame.
+     * @param value The value to store.
+     */
+    static void write(uint8_t* data, uint32_t value) { FrameBytes<Size>::write(data + Offset, value); }
+
+    /**
+     * @brief Loads the field.
+     * @param data The frame.
+     * @return The zero-extended field value.
+     */
+    static uint32_t read(const uint8_t* data) { return FrameBytes<Size>::read(data + Offset); }
+};
+
+/**
+ * @struct NextField
+ * @brief A field of Size bytes directly following the field Previous.
+ */
+template <typename Previous, size_t Size>
+struct NextField : FrameField<Previous::END, Size> {};
+
+#endif // FRAME_LAYOUT_H
@@ -0,0 +1,391 @@
+/**
+ * @file FrameLog.h
+ * @brief This file contains the FrameLog class, an append-only ring log of received frames in a raw flash partition.
+ */
+
+#ifndef FRAME_LOG_H
+#define FRAME_LOG_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "Crc16.h"
+#include "FrameLayout.h"
+
+/**
+ * @class FrameLog
+ * @brief Store-and-forward log of the frames a gateway receives, kept in flash across resets and deep sleep.
+ *
+ * Records are collected in a RAM batch and written to flash together by flush(), which the
+ * owner calls outside the radio path (before deep sleep). append() never touches flash, since a
+ * sector erase stalls both cores for tens of milliseconds: a frame that does not fit into the
+ * batch is dropped and counted. The partition is used as a ring of 4 KB erase sectors, each
+ * starting with a header that carries an increasing sequence number; when the ring is full the
+ * oldest sector is erased and reused, so every sector wears evenly. flush() erases the next
+ * sector ahead of time once the current one has less room left than a batch.
+ *
+ * Record layout (little-endian): payload length, node ID, timestamp in seconds, RSSI in dBm,
+ * SNR in quarter dB, payload, CRC-16 over everything before it. Erased flash reads as a length
+ * of 0xFFFF, which marks the end of the written part of a sector. A record cut short by a reset
+ * fails its CRC and is skipped on replay.
+ */
+class FrameLog {
+public:
+    static const size_t SECTOR_SIZE = 4096;   // Flash erase unit
+    static const size_t BATCH_SIZE = 2048;    // RAM batch, written to flash by flush(); holds a busy cycle's frames
+    static const size_t MAX_PAYLOAD = 255;    // Largest frame
+    static const uint32_t MAGIC = 0x464C4F47; // Marks a sector written by this class ("FLOG")
+
+    typedef FrameField<0, 4> SectorMagicField;                  // Sector header: MAGIC
+    typedef NextField<SectorMagicField, 4> SectorSequenceField; // Sector header: sequence number, oldest sector lowest
+    static const size_t SECTOR_HEADER_SIZE = SectorSequenceField::END;
+
+    typedef FrameField<0, 2> LengthField;                   // Payload length, 0xFFFF in erased flash
+    typedef NextField<LengthField, 2> NodeField;            // Node ID of the sender
+    typedef NextField<NodeField, 4> TimestampField;         // Reception time in seconds
+    typedef NextField<TimestampField, 1> RssiField;         // RSSI in dBm, signed
+    typedef NextField<RssiField, 1> SnrField;               // SNR in quarter dB, signed
+    typedef FrameField<0, 2> ChecksumField;                 // CRC-16, relative to the end of the payload
+    static const size_t RECORD_HEADER_SIZE = SnrField::END;
+    static const size_t MAX_RECORD_SIZE = RECORD_HEADER_SIZE + MAX_PAYLOAD + ChecksumField::SIZE;
+
+    /**
+     * @struct Record
+     * @brief One logged frame, as read back by replay().
+     */
+    struct Record {
+        uint16_t nodeId;              // Node ID of the sender
+        uint32_t timestamp;           // Reception time in seconds
+        int8_t rssi;                  // RSSI in dBm
+        int8_t snrQuarterDb;          // SNR in quarter dB
+        size_t length;                // Payload length
+        uint8_t payload[MAX_PAYLOAD]; // The frame
+    };
+
+    /**
+     * @brief Constructor for FrameLog, call begin() before appending.
+     */
+    FrameLog() : _partition(NULL), _sectorCount(0), _sector(0), _sequence(0), _offset(SECTOR_SIZE), _nextErased(false), _batchLength(0), _dropped(0) {}
+
+    /**
+     * @brief Opens the partition and finds the end of the log written before the last reset.
+     * @param label Label of the data partition in partitions.csv, see examples/main.
+     * @return False if the partition is missing or smaller than two sectors.
+     */
+    bool begin(const char* label = "framelog") {
+        _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+        if (_partition == NULL || _partition->size < 2 * SECTOR_SIZE) {
+            _partition = NULL;
+            return false;
+        }
+        _sectorCount = _partition->size / SECTOR_SIZE;
+
+        bool found = false;
+        for (uint32_t i = 0; i < _sectorCount; ++i) {
+            uint32_t sequence = 0;
+            if (readSectorHeader(i, sequence) && (!found || sequence > _sequence)) {
+                _sector = i;
+                _sequence = sequence;
+                found = true;
+            }
+        }
+        _offset = found ? scanEnd(_sector) : SECTOR_SIZE; // Without a log, the first append opens sector 0
+        if (!found) {
+            _sector = _sectorCount - 1;
+        }
+        _nextErased = false;
+        _batchLength = 0;
+        return true;
+    }
+
+    /**
+     * @brief Adds a frame to the batch without touching flash, so it is safe in the radio path.
+     * @param nodeId Node ID of the sender.
+     * @param timestamp Reception time in seconds.
+     * @param rssi RSSI in dBm.
+     * @param snr SNR in dB.
+     * @param payload The frame.
+     * @param length The length of the frame, at most MAX_PAYLOAD.
+     * @return False if the log is not open, the frame is too long or the batch is full.
+     */
+    bool append(uint16_t nodeId, uint32_t timestamp, float rssi, float snr, const uint8_t* payload, size_t length) {
+        size_t recordSize = RECORD_HEADER_SIZE + length + ChecksumField::SIZE;
+        if (_partition == NULL || length > MAX_PAYLOAD || _batchLength + recordSize > BATCH_SIZE) {
+            _dropped++;
+            return false;
+        }
+
+        uint8_t* record = _batch + _batchLength;
+        LengthField::write(record, (uint32_t)length);
+        NodeField::write(record, nodeId);
+        TimestampField::write(record, timestamp);
+        RssiField::write(record, (uint8_t)clampInt8(rssi));
+        SnrField::write(record, (uint8_t)clampInt8(snr * 4));
+        memcpy(record + RECORD_HEADER_SIZE, payload, length);
+        ChecksumField::write(record + RECORD_HEADER_SIZE + length, crc16(record, RECORD_HEADER_SIZE + length));
+        _batchLength += recordSize;
+        return true;
+    }
+
+    /**
+     * @brief Writes the batch to flash, moving on to the next sector where the current one is full.
+     *
+     * Erases sectors, so call it outside the radio path.
+     * @return False if flash could not be written; the records not yet written are kept for the next attempt.
+     */
+    bool flush() {
+        if (_batchLength == 0) {
+            return true;
+        }
+        if (_partition == NULL) {
+            return false;
+        }
+        size_t written = 0;
+        while (written < _batchLength) {
+            // Records never straddle two sectors, so write the ones that fit into this sector in one go
+            size_t chunk = 0;
+            while (written + chunk < _batchLength) {
+                size_t recordSize = RECORD_HEADER_SIZE + LengthField::read(_batch + written + chunk) + ChecksumField::SIZE;
+                if (_offset + chunk + recordSize > SECTOR_SIZE) {
+                    break;
+                }
+                chunk += recordSize;
+            }
+            bool ok = chunk > 0 ? esp_partition_write(_partition, (size_t)_sector * SECTOR_SIZE + _offset, _batch + written, chunk) == ESP_OK
+                                : openSector((_sector + 1) % _sectorCount);
+            if (!ok) {
+                _batchLength -= written;
+                memmove(_batch, _batch + written, _batchLength);
+                return false;
+            }
+            _offset += chunk;
+            written += chunk;
+        }
+        _batchLength = 0;
+
+        // Erase the next sector now if the next batch may not fit into this one
+        if (SECTOR_SIZE - _offset < BATCH_SIZE && !_nextErased) {
+            _nextErased = esp_partition_erase_range(_partition, (size_t)((_sector + 1) % _sectorCount) * SECTOR_SIZE, SECTOR_SIZE) == ESP_OK;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Prints every intact record, oldest first, one line per frame.
+     *
+     * Flushes the batch first. Blocks while the whole log is read, so call it outside the radio path.
+     * @param out The output, e.g. Serial.
+     * @return The number of records printed.
+     */
+    uint32_t replay(Print& out) {
+        if (_partition == NULL || !flush()) {
+            return 0;
+        }
+        uint32_t first = 0;
+        uint32_t firstSequence = 0;
+        bool found = false;
+        for (uint32_t i = 0; i < _sectorCount; ++i) {
+            uint32_t sequence = 0;
+            if (readSectorHeader(i, sequence) && (!found || sequence < firstSequence)) {
+                first = i;
+                firstSequence = sequence;
+                found = true;
+            }
+        }
+
+        uint32_t count = 0;
+        uint32_t expected = firstSequence;
+        for (uint32_t i = 0; found && i < _sectorCount; ++i) {
+            uint32_t sector = (first + i) % _sectorCount;
+            uint32_t sequence = 0;
+            if (!readSectorHeader(sector, sequence) || sequence != expected) {
+                break; // Past the newest sector
+            }
+            expected++;
+
+            Record record;
+            size_t offset = SECTOR_HEADER_SIZE;
+            while (readRecord(sector, offset, record)) {
+                print(out, record);
+                count++;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * @brief Erases the whole log, e.g. once the replayed records were forwarded.
+     * @return False if the erase failed.
+     */
+    bool clear() {
+        if (_partition == NULL || esp_partition_erase_range(_partition, 0, (size_t)_sectorCount * SECTOR_SIZE) != ESP_OK) {
+            return false;
+        }
+        _sector = _sectorCount - 1;
+        _sequence = 0;
+        _offset = SECTOR_SIZE;
+        _nextErased = true;
+        _batchLength = 0;
+        return true;
+    }
+
+    /**
+     * @brief Getter for the number of frames that could not be logged.
+     * @return The number of failed append() calls.
+     */
+    uint32_t getDropped() const { return _dropped; }
+
+    /**
+     * @brief Getter for the bytes waiting in the batch.
+     * @return The batch length in bytes.
+     */
+    size_t getPending() const { return _batchLength; }
+
+private:
+    const esp_partition_t* _partition; // The log partition, NULL until begin() succeeds
+    uint32_t _sectorCount;             // Sectors in the partition
+    uint32_t _sector;                  // Sector being written
+    uint32_t _sequence;                // Sequence number of the sector being written
+    size_t _offset;                    // Next free byte in the sector, SECTOR_SIZE when it is full
+    bool _nextErased;                  // True if the sector after the current one is already erased
+    uint8_t _batch[BATCH_SIZE];        // Records not yet written
+    size_t _batchLength;               // Bytes in the batch
+    uint32_t _dropped;                 // Failed append() calls
+
+    /**
+     * @brief Starts the sector after the current one with the next sequence number, erasing it unless flush() already did.
+     * @param sector The sector index.
+     * @return False if flash could not be erased or written.
+     */
+    bool openSector(uint32_t sector) {
+        uint8_t header[SECTOR_HEADER_SIZE];
+        SectorMagicField::write(header, MAGIC);
+        SectorSequenceField::write(header, _sequence + 1);
+        size_t address = (size_t)sector * SECTOR_SIZE;
+        if ((!_nextErased && esp_partition_erase_range(_partition, address, SECTOR_SIZE) != ESP_OK) ||
+            esp_partition_write(_partition, address, header, sizeof(header)) != ESP_OK) {
+            return false;
+        }
+        _nextErased = false;
+        _sector = sector;
+        _sequence++;
+        _offset = SECTOR_HEADER_SIZE;
+        return true;
+    }
+
+    /**
+     * @brief Reads the header of a sector.
+     * @param sector The sector index.
+     * @param sequence Set to the sector's sequence number.
+     * @return True if the sector belongs to the log.
+     */
+    bool readSectorHeader(uint32_t sector, uint32_t& sequence) const {
+        uint8_t header[SECTOR_HEADER_SIZE];
+        if (esp_partition_read(_partition, (size_t)sector * SECTOR_SIZE, header, sizeof(header)) != ESP_OK ||
+            SectorMagicField::read(header) != MAGIC) {
+            return false;
+        }
+        sequence = SectorSequenceField::read(header);
+        return true;
+    }
+
+    /**
+     * @brief Reads the length field of the record at an offset.
+     * @param sector The sector index.
+     * @param offset Offset of the record in the sector.
+     * @param recordSize Set to the size of the whole record.
+     * @return False at the end of the written part of the sector.
+     */
+    bool readRecordSize(uint32_t sector, size_t offset, size_t& recordSize) const {
+        uint8_t field[LengthField::SIZE];
+        if (offset + RECORD_HEADER_SIZE + ChecksumField::SIZE > SECTOR_SIZE ||
+            esp_partition_read(_partition, (size_t)sector * SECTOR_SIZE + offset, field, sizeof(field)) != ESP_OK) {
+            return false;
+        }
+        uint32_t length = LengthField::read(field);
+        recordSize = RECORD_HEADER_SIZE + length + ChecksumField::SIZE;
+        return length <= MAX_PAYLOAD && offset + recordSize <= SECTOR_SIZE; // Erased flash reads 0xFFFF
+    }
+
+    /**
+     * @brief Finds the first free byte of a sector.
+     * @param sector The sector index.
+     * @return The offset, SECTOR_SIZE if the sector cannot take more records.
+     */
+    size_t scanEnd(uint32_t sector) const {
+        size_t offset = SECTOR_HEADER_SIZE;
+        size_t recordSize = 0;
+        while (readRecordSize(sector, offset, recordSize)) {
+            offset += recordSize;
+        }
+        uint8_t field[LengthField::SIZE];
+        if (offset + LengthField::SIZE <= SECTOR_SIZE &&
+            esp_partition_read(_partition, (size_t)sector * SECTOR_SIZE + offset, field, sizeof(field)) == ESP_OK &&
+            LengthField::read(field) == 0xFFFF) {
+            return offset;
+        }
+        return SECTOR_SIZE; // Stopped at a damaged length field, leave the rest of the sector alone
+    }
+
+    /**
+     * @brief Reads the next intact record of a sector, skipping records that fail their CRC.
+     * @param sector The sector index.
+     * @param offset Offset of the record, advanced past it.
+     * @param record Set to the record.
+     * @return False at the end of the sector.
+     */
+    bool readRecord(uint32_t sector, size_t& offset, Record& record) const {
+        uint8_t data[MAX_RECORD_SIZE];
+        size_t recordSize = 0;
+        while (readRecordSize(sector, offset, recordSize)) {
+            size_t address = (size_t)sector * SECTOR_SIZE + offset;
+            offset += recordSize;
+            size_t length = recordSize - RECORD_HEADER_SIZE - ChecksumField::SIZE;
+            if (esp_partition_read(_partition, address, data, recordSize) != ESP_OK ||
+                ChecksumField::read(data + RECORD_HEADER_SIZE + length) != crc16(data, RECORD_HEADER_SIZE + length)) {
+                continue;
+            }
+            record.nodeId = (uint16_t)NodeField::read(data);
+            record.timestamp = TimestampField::read(data);
+            record.rssi = (int8_t)RssiField::read(data);
+            record.snrQuarterDb = (int8_t)SnrField::read(data);
+            record.length = length;
+            memcpy(record.payload, data + RECORD_HEADER_SIZE, length);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Prints one record as "log <node> <time> <rssi> dBm <snr> dB <payload hex>".
+     * @param out The output.
+     * @param record The record.
+     */
+    static void print(Print& out, const Record& record) {
+        char line[64];
+        snprintf(line, sizeof(line), "log %04X %lu %d dBm %.2f dB ",
+                 (unsigned int)record.nodeId, (unsigned long)record.timestamp, (int)record.rssi, record.snrQuarterDb / 4.0f);
+        out.print(line);
+        for (size_t i = 0; i < record.length; ++i) {
+            snprintf(line, sizeof(line), "%02X", (unsigned int)record.payload[i]);
+            out.print(line);
+        }
+        out.println();
+    }
+
+    /**
+     * @brief Rounds a value into the int8_t range.
+     * @param value The value.
+     * @return The rounded and clamped value.
+     */
+    static int8_t clampInt8(float value) {
+        if (value <= -128.0f) {
+            return -128;
+        }
+        if (value >= 127.0f) {
+            return 127;
+        }
+        return (int8_t)lroundf(value);
+    }
+};
+
+#endif // FRAME_LOG_H
@@ -0,0 +1,143 @@
+#ifndef GPS_FRAME_H // Prevents multiple inclusions of this header file
+#define GPS_FRAME_H
+
+#include <Arduino.h> // Includes the Arduino core library
+#include "FrameLayout.h" // Includes the compile-time frame field descriptions
+
+// GpsFrame class definition
+// Compact binary position frame. Coordinates travel as int32 microdegrees, either
+// absolute (a keyframe) or as a small delta against the last keyframe. Deltas always
+// refer to the keyframe, not to the previous frame, so a lost delta costs one position
+// and a lost keyframe at most KEYFRAME_INTERVAL positions.
+//
+// Layout (little-endian), byte 0 holds the mode (bits 0-1) and keyframe ID (bits 4-7):
+//   no fix:  mode                                   1 byte
+//   delta8:  mode, int8 dLat, int8 dLon             3 bytes
+//   delta16: mode, int16 dLat, int16 dLon           5 bytes
+//   keyframe: mode, int32 lat, int32 lon            9 bytes
+class GpsFrame {
+public:
+    // Wire layout of each mode
+    typedef FrameField<0, 1> HeaderField; // Mode and keyframe ID
+    typedef NextField<HeaderField, 1> Delta8LatField; // int8 latitude delta
+    typedef NextField<Delta8LatField, 1> Delta8LonField; // int8 longitude delta
+    typedef NextField<HeaderField, 2> Delta16LatField; // int16 latitude delta
+    typedef NextField<Delta16LatField, 2> Delta16LonField; // int16 longitude delta
+    typedef NextField<HeaderField, 4> KeyframeLatField; // int32 latitude
+    typedef NextField<KeyframeLatField, 4> KeyframeLonField; // int32 longitude
+
+    static const uint8_t MODE_NO_FIX = 0; // No position available
+    static const uint8_t MODE_KEYFRAME = 1; // Absolute position, becomes the delta reference
+    static const uint8_t MODE_DELTA8 = 2; // 8-bit deltas against the keyframe
+    static const uint8_t MODE_DELTA16 = 3; // 16-bit deltas against the keyframe
+    static const size_t NO_FIX_SIZE = HeaderField::END; // Size of a frame without fix
+    static const size_t DELTA8_SIZE = Delta8LonField::END; // Size of an 8-bit delta frame
+    static const size_t DELTA16_SIZE = Delta16LonField::END; // Size of a 16-bit delta frame
+    static const size_t MAX_SIZE = KeyframeLonField::END; // Size of a keyframe, the largest frame
+    static const uint8_t KEYFRAME_INTERVAL = 10; // Frames between two keyframes
+
+    // Constructor that starts without a delta reference, so the first fix is sent as a keyframe
+    GpsFrame() : referenceLat(0), referenceLon(0), hasReference(false), keyframeId(0), framesSinceKeyframe(0) {}
+
+    // Converts degrees to the fixed-point microdegrees carried in the frame
+    static int32_t toMicrodegrees(double degrees) { return (int32_t)lround(degrees * 1000000.0); }
+    // Converts fixed-point microdegrees back to degrees
+    static double toDegrees(int32_t microdegrees) { return microdegrees / 1000000.0; }
+
+    // Serializes a position into the smallest fitting frame and returns the number of bytes written
+    // data must hold MAX_SIZE bytes
+    size_t serialize(bool hasFix, int32_t lat, int32_t lon, uint8_t* data) {
+        if (!hasFix) {
+            HeaderField::write(data, header(MODE_NO_FIX));
+            return NO_FIX_SIZE;
+        }
+
+        int32_t dLat = lat - referenceLat;
+        int32_t dLon = lon - referenceLon;
+        if (hasReference && framesSinceKeyframe < KEYFRAME_INTERVAL) {
+            if (fits(dLat, 127) && fits(dLon, 127)) {
+                framesSinceKeyframe++;
+                HeaderField::write(data, header(MODE_DELTA8));
+                Delta8LatField::write(data, (uint32_t)dLat);
+                Delta8LonField::write(data, (uint32_t)dLon);
+                return DELTA8_SIZE;
+            }
+            if (fits(dLat, 32767) && fits(dLon, 32767)) {
+                framesSinceKeyframe++;
+                HeaderField::write(data, header(MODE_DELTA16));
+                Delta16LatField::write(data, (uint32_t)dLat);
+                Delta16LonField::write(data, (uint32_t)dLon);
+                return DELTA16_SIZE;
+            }
+        }
+
+        // Start a new keyframe
+        keyframeId = (uint8_t)((keyframeId + 1) & 0x0F);
+        referenceLat = lat;
+        referenceLon = lon;
+        hasReference = true;
+        framesSinceKeyframe = 0;
+        HeaderField::write(data, header(MODE_KEYFRAME));
+        KeyframeLatField::write(data, (uint32_t)lat);
+        KeyframeLonField::write(data, (uint32_t)lon);
+        return MAX_SIZE;
+    }
+
+    // Deserializes a frame and returns false if it is malformed or refers to a keyframe that was not received
+    bool deserialize(const uint8_t* data, size_t length, bool& hasFix, int32_t& lat, int32_t& lon) {
+        if (length == 0) {
+            return false;
+        }
+
+        uint8_t mode = HeaderField::read(data) & 0x03;
+        uint8_t id = HeaderField::read(data) >> 4;
+        hasFix = mode != MODE_NO_FIX;
+        switch (mode) {
+            case MODE_NO_FIX:
+                return length == NO_FIX_SIZE;
+            case MODE_KEYFRAME:
+                if (length != MAX_SIZE) {
+                    return false;
+                }
+                lat = (int32_t)KeyframeLatField::read(data);
+                lon = (int32_t)KeyframeLonField::read(data);
+                referenceLat = lat;
+                referenceLon = lon;
+                keyframeId = id;
+                hasReference = true;
+                return true;
+            case MODE_DELTA8:
+                if (length != DELTA8_SIZE || !hasReference || id != keyframeId) {
+                    return false;
+                }
+                lat = referenceLat + (int8_t)Delta8LatField::read(data);
+                lon = referenceLon + (int8_t)Delta8LonField::read(data);
+                return true;
+            default: // MODE_DELTA16
+                if (length != DELTA16_SIZE || !hasReference || id != keyframeId) {
+                    return false;
+                }
+                lat = referenceLat + (int16_t)Delta16LatField::read(data);
+                lon = referenceLon + (int16_t)Delta16LonField::read(data);
+                return true;
+        }
+    }
+
+    // Forces the next fix to be sent as a keyframe
+    void resetReference() { hasReference = false; }
+
+private:
+    int32_t referenceLat; // Latitude of the last keyframe in microdegrees
+    int32_t referenceLon; // Longitude of the last keyframe in microdegrees
+    bool hasReference; // True once a keyframe was sent or received
+    uint8_t keyframeId; // 4-bit ID of the last keyframe
+    uint8_t framesSinceKeyframe; // Delta frames sent since the last keyframe
+
+    // Builds the first byte of a frame from a mode and the current keyframe ID
+    uint8_t header(uint8_t mode) const { return (uint8_t)((keyframeId << 4) | mode); }
+
+    // Checks whether a delta fits in a signed field with the given limit
+    static bool fits(int32_t delta, int32_t limit) { return delta >= -limit && delta <= limit; }
+};
+
+#endif // GPS_FRAME_H
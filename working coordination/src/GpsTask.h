@@ -0,0 +1,177 @@
+#ifndef GPS_TASK_H // Prevents multiple inclusions of this header file
+#define GPS_TASK_H
+
+#include <Arduino.h>     // Includes the Arduino core library
+#include <TinyGPSPlus.h> // Includes the NMEA parser
+#include "driver/uart.h" // Includes the ESP-IDF UART driver
+
+// Latest GPS data, published by the GPS task
+struct GpsSnapshot {
+    bool locationValid;       // True if lat/lng hold a fix
+    double lat;               // Latitude in degrees
+    double lng;               // Longitude in degrees
+    bool altitudeValid;       // True if altitudeMeters holds a value
+    double altitudeMeters;    // Altitude in meters
+    uint32_t satellites;      // Satellites in use
+    uint32_t fixMillis;       // millis() when the location was last updated
+    uint32_t charsProcessed;  // NMEA characters parsed so far
+    uint32_t overflows;       // UART overflows, each one drops buffered NMEA data
+};
+
+// GpsTask class definition
+// Reads NMEA sentences on a FreeRTOS task pinned to one core. The UART driver signals whole
+// lines through its event queue (pattern detection on '\n'), so bytes are taken out of the
+// FIFO as they arrive and nothing depends on how often loop() runs. The task is the single
+// writer of a sequence-locked snapshot; readers copy it without taking a lock.
+class GpsTask {
+public:
+    static const int RX_BUFFER_SIZE = 2048;  // UART driver ring buffer, holds several sentences at 10 Hz
+    static const int EVENT_QUEUE_LENGTH = 20; // UART events and pattern positions kept by the driver
+    static const size_t READ_CHUNK = 128;    // Bytes moved from the driver into the parser at a time
+    static const uint8_t READ_ATTEMPTS = 8;  // Snapshot copies tried before read() gives up
+
+    // Constructor that stores the UART settings, call begin() to start the task
+    GpsTask(uart_port_t port, int rxPin, int txPin, int baudRate = 9600)
+        : port(port), rxPin(rxPin), txPin(txPin), baudRate(baudRate), queue(NULL), sequence(0), overflows(0) {
+        memset((void*)&snapshot, 0, sizeof(snapshot));
+    }
+
+    // Installs the UART driver and starts the GPS task on the given core, returns false on failure
+    bool begin(BaseType_t core = 0, UBaseType_t priority = 2) {
+        uart_config_t config;
+        memset(&config, 0, sizeof(config));
+        config.baud_rate = baudRate;
+        config.data_bits = UART_DATA_8_BITS;
+        config.parity = UART_PARITY_DISABLE;
+        config.stop_bits = UART_STOP_BITS_1;
+        config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+
+        if (uart_driver_install(port, RX_BUFFER_SIZE, 0, EVENT_QUEUE_LENGTH, &queue, 0) != ESP_OK ||
+            uart_param_config(port, &config) != ESP_OK ||
+            uart_set_pin(port, txPin, rxPin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE) != ESP_OK ||
+            uart_enable_pattern_det_baud_intr(port, '\n', 1, 9, 0, 0) != ESP_OK ||
+            uart_pattern_queue_reset(port, EVENT_QUEUE_LENGTH) != ESP_OK) {
+            return false;
+        }
+
+        return xTaskCreatePinnedToCore(taskEntry, "GpsTask", 4096, this, priority, NULL, core) == pdPASS;
+    }
+
+    // Copies the latest snapshot, returns false if the task kept updating it during every attempt
+    bool read(GpsSnapshot& out) const {
+        for (uint8_t attempt = 0; attempt < READ_ATTEMPTS; ++attempt) {
+            uint32_t before = sequence;
+            if (before & 1) {
+                continue; // Update in progress
+            }
+            __sync_synchronize();
+            memcpy(&out, (const void*)&snapshot, sizeof(out));
+            __sync_synchronize();
+            if (sequence == before) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Sends raw bytes to the GPS module, e.g. configuration sentences
+    int write(const uint8_t* data, size_t length) {
+        return uart_write_bytes(port, (const char*)data, length);
+    }
+
+private:
+    uart_port_t port; // UART the GPS module is wired to
+    int rxPin; // GPIO receiving from the GPS module
+    int txPin; // GPIO sending to the GPS module
+    int baudRate; // GPS baud rate
+    QueueHandle_t queue; // UART driver event queue
+    TinyGPSPlus gps; // NMEA parser, only touched by the GPS task
+    volatile uint32_t sequence; // Odd while the snapshot is being written
+    volatile GpsSnapshot snapshot; // Latest published data
+    uint32_t overflows; // UART overflows counted by the GPS task
+
+    // FreeRTOS entry point
+    static void taskEntry(void* parameter) {
+        static_cast<GpsTask*>(parameter)->run();
+    }
+
+    // Waits for UART events and feeds complete lines into the parser
+    void run() {
+        uart_event_t event;
+        while (true) {
+            if (xQueueReceive(queue, &event, portMAX_DELAY) != pdTRUE) {
+                continue;
+            }
+
+            switch (event.type) {
+                case UART_PATTERN_DET: {
+                    int position = uart_pattern_pop_pos(port);
+                    if (position < 0) {
+                        resync(); // The pattern queue overflowed, positions are no longer valid
+                    } else {
+                        readLine((size_t)position + 1);
+                    }
+                    break;
+                }
+                case UART_FIFO_OVF:
+                case UART_BUFFER_FULL:
+                    overflows++;
+                    resync();
+                    break;
+                default:
+                    break; // Data stays in the ring buffer until its line is complete
+            }
+        }
+    }
+
+    // Moves one line out of the driver and publishes the snapshot if a sentence completed
+    void readLine(size_t length) {
+        uint8_t buffer[READ_CHUNK];
+        bool updated = false;
+        while (length > 0) {
+            int count = uart_read_bytes(port, buffer, length < READ_CHUNK ? length : READ_CHUNK, pdMS_TO_TICKS(10));
+            if (count <= 0) {
+                break;
+            }
+            for (int i = 0; i < count; ++i) {
+                if (gps.encode((char)buffer[i])) {
+                    updated = true;
+                }
+            }
+            length -= (size_t)count;
+        }
+        if (updated) {
+            publish();
+        }
+    }
+
+    // Drops buffered data and pending events after an overflow
+    void resync() {
+        uart_flush_input(port);
+        xQueueReset(queue);
+        publish();
+    }
+
+    // Writes the parser state into the snapshot, bracketed by sequence increments
+    void publish() {
+        GpsSnapshot next;
+        bool moved = gps.location.isUpdated(); // Must be read first, lat() and lng() clear it
+        next.locationValid = gps.location.isValid();
+        next.lat = gps.location.lat();
+        next.lng = gps.location.lng();
+        next.altitudeValid = gps.altitude.isValid();
+        next.altitudeMeters = gps.altitude.meters();
+        next.satellites = gps.satellites.value();
+        next.fixMillis = moved ? millis() : snapshot.fixMillis;
+        next.charsProcessed = gps.charsProcessed();
+        next.overflows = overflows;
+
+        sequence = sequence + 1; // Odd: readers retry
+        __sync_synchronize();
+        memcpy((void*)&snapshot, &next, sizeof(next));
+        __sync_synchronize();
+        sequence = sequence + 1; // Even: snapshot consistent
+    }
+};
+
+#endif // GPS_TASK_H
@@ -0,0 +1,197 @@
+/**
+ * @file JobScheduler.h
+ * @brief This file contains the JobScheduler class, which merges the deadlines of a node's periodic jobs into as few wakes as possible.
+ */
+
+#ifndef JOB_SCHEDULER_H
+#define JOB_SCHEDULER_H
+
+#include <Arduino.h>
+
+/**
+ * @class JobScheduler
+ * @brief Min-heap of job deadlines on the RTC clock of WakeScheduler::nowUs().
+ *
+ * Each job is due at a time and may run up to its tolerance later. The node wakes at the
+ * earliest deadline (due time plus tolerance) and runs every job already due, so a job with
+ * slack rides along with the next wake another job needs instead of adding its own. The
+ * coordination cycle is a one-shot job with no tolerance, rescheduled from the Timer's
+ * interval every cycle; periodic jobs such as a battery report are re-armed one period later
+ * each time they run.
+ *
+ * The class has no constructor so that an instance can be kept in RTC memory
+ * across deep sleep. Call reset() after a normal boot.
+ */
+class JobScheduler {
+public:
+    static const uint8_t MAX_JOBS = 8;    // Capacity of the heap
+    static const uint8_t NO_JOB = 0xFF;   // Returned by takeDue() when nothing is due
+    static const int64_t NEVER = INT64_MAX; // Deadline of an empty scheduler
+
+    /**
+     * @brief Drops every job.
+     */
+    void reset() {
+        count = 0;
+        memset(jobs, 0, sizeof(jobs));
+    }
+
+    /**
+     * @brief Adds a job, or moves it if a job with the same ID is already scheduled.
+     * @param id Identifier of the job, any value but NO_JOB.
+     * @param dueUs Time the job becomes due, in WakeScheduler::nowUs() microseconds.
+     * @param periodMs Interval between runs in milliseconds, 0 for a job that runs once.
+     * @param toleranceMs Time the job may run after it is due, in milliseconds.
+     * @return False if the ID is NO_JOB or the heap is full.
+     */
+    bool schedule(uint8_t id, int64_t dueUs, uint32_t periodMs = 0, uint32_t toleranceMs = 0) {
+        if (id == NO_JOB) {
+            return false;
+        }
+        cancel(id);
+        if (count >= MAX_JOBS) {
+            return false;
+        }
+        Job& job = jobs[count];
+        job.dueUs = dueUs;
+        job.periodMs = periodMs;
+        job.toleranceMs = toleranceMs;
+        job.id = id;
+        siftUp(count++);
+        return true;
+    }
+
+    /**
+     * @brief Removes a job.
+     * @param id Identifier of the job.
+     * @return True if the job was scheduled.
+     */
+    bool cancel(uint8_t id) {
+        int8_t index = find(id);
+        if (index < 0) {
+            return false;
+        }
+        removeAt((uint8_t)index);
+        return true;
+    }
+
+    /**
+     * @brief Checks whether a job is due.
+     * @param id Identifier of the job.
+     * @param nowUs Current time in WakeScheduler::nowUs() microseconds.
+     * @return True if the job is scheduled and its due time has passed.
+     */
+    bool isDue(uint8_t id, int64_t nowUs) const {
+        int8_t index = find(id);
+        return index >= 0 && jobs[index].dueUs <= nowUs;
+    }
+
+    /**
+     * @brief Takes the next job that is due, re-arming it if periodic.
+     *
+     * Call repeatedly until it returns NO_JOB to run everything this wake can batch. A periodic
+     * job that fell behind by several periods runs once and is re-armed after nowUs.
+     * @param nowUs Current time in WakeScheduler::nowUs() microseconds.
+     * @return Identifier of the job to run, NO_JOB if none is due.
+     */
+    uint8_t takeDue(int64_t nowUs) {
+        for (uint8_t i = 0; i < count; ++i) {
+            if (jobs[i].dueUs > nowUs) {
+                continue;
+            }
+            Job job = jobs[i];
+            removeAt(i);
+            if (job.periodMs > 0) {
+                int64_t periodUs = (int64_t)job.periodMs * 1000LL;
+                int64_t missed = (nowUs - job.dueUs) / periodUs + 1;
+                schedule(job.id, job.dueUs + missed * periodUs, job.periodMs, job.toleranceMs);
+            }
+            return job.id;
+        }
+        return NO_JOB;
+    }
+
+    /**
+     * @brief Getter for the latest time the node may wake without missing a deadline.
+     * @return The earliest deadline in WakeScheduler::nowUs() microseconds, NEVER without jobs.
+     */
+    int64_t nextWakeUs() const { return count > 0 ? deadlineOf(jobs[0]) : NEVER; }
+
+    /**
+     * @brief Getter for the number of scheduled jobs.
+     * @return The number of jobs.
+     */
+    uint8_t size() const { return count; }
+
+private:
+    /**
+     * @struct Job
+     * @brief One scheduled job.
+     */
+    struct Job {
+        int64_t dueUs;        // Time the job becomes due
+        uint32_t periodMs;    // Interval between runs, 0 for a one-shot job
+        uint32_t toleranceMs; // Time the job may run late
+        uint8_t id;           // Identifier of the job
+    };
+
+    Job jobs[MAX_JOBS]; // Heap ordered by deadline, jobs[0] is the earliest
+    uint8_t count;      // Jobs in the heap
+
+    static int64_t deadlineOf(const Job& job) { return job.dueUs + (int64_t)job.toleranceMs * 1000LL; }
+
+    int8_t find(uint8_t id) const {
+        for (uint8_t i = 0; i < count; ++i) {
+            if (jobs[i].id == id) {
+                return (int8_t)i;
+            }
+        }
+        return -1;
+    }
+
+    void removeAt(uint8_t index) {
+        jobs[index] = jobs[--count];
+        if (index < count) {
+            siftDown(index);
+            siftUp(index);
+        }
+    }
+
+    void siftUp(uint8_t index) {
+        while (index > 0) {
+            uint8_t parent = (uint8_t)((index - 1) / 2);
+            if (deadlineOf(jobs[parent]) <= deadlineOf(jobs[index])) {
+                break;
+            }
+            swap(parent, index);
+            index = parent;
+        }
+    }
+
+    void siftDown(uint8_t index) {
+        while (true) {
+            uint8_t smallest = index;
+            uint8_t left = (uint8_t)(2 * index + 1);
+            uint8_t right = (uint8_t)(left + 1);
+            if (left < count && deadlineOf(jobs[left]) < deadlineOf(jobs[smallest])) {
+                smallest = left;
+            }
+            if (right < count && deadlineOf(jobs[right]) < deadlineOf(jobs[smallest])) {
+                smallest = right;
+            }
+            if (smallest == index) {
+                return;
+            }
+            swap(smallest, index);
+            index = smallest;
+        }
+    }
+
+    void swap(uint8_t a, uint8_t b) {
+        Job job = jobs[a];
+        jobs[a] = jobs[b];
+        jobs[b] = job;
+    }
+};
+
+#endif // JOB_SCHEDULER_H
@@ -0,0 +1,274 @@
+/**
+ * @file LinkMetrics.h
+ * @brief This file contains the LinkMetrics class, a registry of link-quality and airtime counters and histograms with a compact binary snapshot.
+ */
+
+#ifndef LINK_METRICS_H
+#define LINK_METRICS_H
+
+#include <Arduino.h>
+#include "FrameLayout.h"
+#include "Crc16.h"
+
+/**
+ * @class LinkMetrics
+ * @brief Counters and fixed-bucket histograms of everything the radio path used to print and forget.
+ *
+ * Recording only increments a few words, so it runs in the radio path. The whole registry is
+ * read out as one binary snapshot (see serialize()), which printSnapshot() writes to Serial as
+ * a single hex line. A client can also piggyback a short summary on each ACK (see writeSummary()),
+ * giving the host the downlink quality it cannot measure itself.
+ *
+ * Histogram bucket i counts the values below bound(h, i) and at or above the previous bound;
+ * the last bucket collects everything above the last bound.
+ *
+ * Snapshot layout, little-endian: version (1 byte), COUNTER_COUNT counters (4 bytes each),
+ * airtime in milliseconds (4 bytes), HISTOGRAM_COUNT * BUCKET_COUNT bucket counts (2 bytes each),
+ * CRC-16 of everything before it (2 bytes).
+ *
+ * The class has no constructor so that an instance can be kept in RTC memory
+ * across deep sleep. Call reset() after a normal boot. Record from one task only.
+ */
+class LinkMetrics {
+public:
+    /**
+     * @enum Counter
+     * @brief Counted events.
+     */
+    enum Counter {
+        FRAMES_SENT,       // Frames that left the radio
+        SEND_FAILURES,     // Frames that failed to start or never signalled TX done
+        FRAMES_RECEIVED,   // Frames read from the radio
+        RECEIVE_ERRORS,    // Frames the radio flagged, e.g. with a bad LoRa CRC
+        CHECKSUM_ERRORS,   // Beacons that failed the Timer checksum
+        BEACON_RESENDS,    // Beacons a host sent after the first of a cycle
+        BEACONS_MISSED,    // Warm listen windows a client closed without a beacon
+        ACK_RETRIES,       // ACKs a client sent after the first of an exchange
+        ACKS_UNCONFIRMED,  // ACK exchanges that ended without a confirmation
+        ACKS_RECEIVED,     // ACKs a host accepted
+        FRAMES_HELD_BACK,  // Frames the airtime budget kept off the air
+        COUNTER_COUNT      // Number of counters
+    };
+
+    /**
+     * @enum Histogram
+     * @brief Measured distributions.
+     */
+    enum Histogram {
+        HIST_RSSI,        // RSSI of received frames in dBm
+        HIST_SNR,         // SNR of received frames in dB
+        HIST_TIME_ON_AIR, // Time on air of sent frames in milliseconds
+        HIST_ACK_LATENCY, // End of a beacon until its ACK was confirmed (client) or received (host), in milliseconds
+        HIST_SYNC_ERROR,  // Distance of a warm client's beacon from the predicted sync, in milliseconds
+        HISTOGRAM_COUNT   // Number of histograms
+    };
+
+    static const uint8_t BUCKET_COUNT = 8;   // Buckets per histogram
+    static const uint8_t SNAPSHOT_VERSION = 2; // Version byte of the snapshot layout
+    static const size_t SNAPSHOT_SIZE = 1 + 4 * COUNTER_COUNT + 4 + 2 * HISTOGRAM_COUNT * BUCKET_COUNT + 2; // Size of a snapshot
+
+    typedef FrameField<0, 1> SummaryRssiField;                         // Summary: RSSI of the last beacon in dBm
+    typedef NextField<SummaryRssiField, 1> SummarySnrField;            // Summary: SNR of the last beacon in quarter dB
+    typedef NextField<SummarySnrField, 1> SummaryChecksumErrorsField;  // Summary: CHECKSUM_ERRORS, low byte
+    typedef NextField<SummaryChecksumErrorsField, 1> SummaryRetriesField; // Summary: ACK_RETRIES, low byte
+    typedef NextField<SummaryRetriesField, 1> SummaryMissedField;      // Summary: BEACONS_MISSED, low byte
+    typedef NextField<SummaryMissedField, 1> SummaryUnconfirmedField;  // Summary: ACKS_UNCONFIRMED, low byte
+    static const size_t SUMMARY_SIZE = SummaryUnconfirmedField::END;   // Size of the ACK summary
+
+    /**
+     * @brief Clears every counter and histogram.
+     */
+    void reset() {
+        memset(this, 0, sizeof(*this));
+    }
+
+    /**
+     * @brief Counts an event.
+     * @param counter The counter.
+     * @param amount The number of events.
+     */
+    void count(Counter counter, uint32_t amount = 1) {
+        counters[counter] += amount;
+    }
+
+    /**
+     * @brief Getter for a counter.
+     * @param counter The counter.
+     * @return The events counted since reset().
+     */
+    uint32_t get(Counter counter) const { return counters[counter]; }
+
+    /**
+     * @brief Adds a value to a histogram.
+     * @param histogram The histogram.
+     * @param value The value, in the unit of the histogram.
+     */
+    void record(Histogram histogram, int32_t value) {
+        uint8_t bucket = 0;
+        while (bucket < BUCKET_COUNT - 1 && value >= bound(histogram, bucket)) {
+            bucket++;
+        }
+        if (buckets[histogram][bucket] < 0xFFFF) {
+            buckets[histogram][bucket]++;
+        }
+    }
+
+    /**
+     * @brief Records a received frame.
+     * @param rssi RSSI of the frame in dBm.
+     * @param snr SNR of the frame in dB.
+     */
+    void recordReceived(float rssi, float snr) {
+        count(FRAMES_RECEIVED);
+        record(HIST_RSSI, (int32_t)floorf(rssi));
+        record(HIST_SNR, (int32_t)floorf(snr));
+    }
+
+    /**
+     * @brief Records the link quality of an accepted beacon, the downlink reported in the ACK summary.
+     *
+     * Kept apart from recordReceived(), which also sees the ACKs and confirmations of
+     * neighbouring clients.
+     * @param rssi RSSI of the beacon in dBm.
+     * @param snr SNR of the beacon in dB.
+     */
+    void recordBeacon(float rssi, float snr) {
+        beaconRssi = rssi;
+        beaconSnr = snr;
+    }
+
+    /**
+     * @brief Records a sent frame.
+     * @param timeOnAirUs Time on air of the frame in microseconds.
+     * @param sent True if the frame left the radio.
+     */
+    void recordSent(uint32_t timeOnAirUs, bool sent) {
+        if (!sent) {
+            count(SEND_FAILURES);
+            return;
+        }
+        count(FRAMES_SENT);
+        airtimeUs += timeOnAirUs;
+        record(HIST_TIME_ON_AIR, (int32_t)(timeOnAirUs / 1000));
+    }
+
+    /**
+     * @brief Getter for the total time on air of the sent frames.
+     * @return The airtime since reset() in milliseconds.
+     */
+    uint32_t getAirtimeMs() const { return (uint32_t)(airtimeUs / 1000); }
+
+    /**
+     * @brief Writes the binary snapshot of the registry.
+     * @param data Buffer of at least SNAPSHOT_SIZE bytes.
+     * @return The number of bytes written, SNAPSHOT_SIZE.
+     */
+    size_t serialize(uint8_t* data) const {
+        uint8_t* out = data;
+        *out++ = SNAPSHOT_VERSION;
+        for (uint8_t i = 0; i < COUNTER_COUNT; ++i) {
+            FrameBytes<4>::write(out, counters[i]);
+            out += 4;
+        }
+        FrameBytes<4>::write(out, getAirtimeMs());
+        out += 4;
+        for (uint8_t h = 0; h < HISTOGRAM_COUNT; ++h) {
+            for (uint8_t i = 0; i < BUCKET_COUNT; ++i) {
+                FrameBytes<2>::write(out, buckets[h][i]);
+                out += 2;
+            }
+        }
+        FrameBytes<2>::write(out, crc16(data, (size_t)(out - data)));
+        return SNAPSHOT_SIZE;
+    }
+
+    /**
+     * @brief Prints the snapshot as one line, "metrics " followed by the snapshot in hex.
+     *
+     * Blocks while the line is written, so call it outside the radio path.
+     * @param out The output, e.g. Serial.
+     */
+    void printSnapshot(Print& out) const {
+        uint8_t data[SNAPSHOT_SIZE];
+        serialize(data);
+        char hex[3];
+        out.print("metrics ");
+        for (size_t i = 0; i < SNAPSHOT_SIZE; ++i) {
+            snprintf(hex, sizeof(hex), "%02x", (unsigned int)data[i]);
+            out.print(hex);
+        }
+        out.println();
+    }
+
+    /**
+     * @brief Writes the summary a client piggybacks on its ACK.
+     *
+     * The counters are sent as their low bytes; the receiver takes the difference to the
+     * previous summary of the same node, which stays correct across the wrap.
+     * @param data Buffer of at least SUMMARY_SIZE bytes.
+     */
+    void writeSummary(uint8_t* data) const {
+        SummaryRssiField::write(data, (uint8_t)clampInt8(beaconRssi));
+        SummarySnrField::write(data, (uint8_t)clampInt8(beaconSnr * 4.0f));
+        SummaryChecksumErrorsField::write(data, counters[CHECKSUM_ERRORS]);
+        SummaryRetriesField::write(data, counters[ACK_RETRIES]);
+        SummaryMissedField::write(data, counters[BEACONS_MISSED]);
+        SummaryUnconfirmedField::write(data, counters[ACKS_UNCONFIRMED]);
+    }
+
+    /**
+     * @brief Prints a summary received with an ACK as one line.
+     * @param out The output, e.g. Serial.
+     * @param nodeId Identifier of the node that sent the summary.
+     * @param data The summary, SUMMARY_SIZE bytes.
+     */
+    static void printSummary(Print& out, uint16_t nodeId, const uint8_t* data) {
+        char line[96];
+        snprintf(line, sizeof(line), "link %x rssi=%d snr=%.2f crc=%u retries=%u missed=%u unconfirmed=%u",
+                 (unsigned int)nodeId, (int)(int8_t)SummaryRssiField::read(data), (int8_t)SummarySnrField::read(data) / 4.0f,
+                 (unsigned int)SummaryChecksumErrorsField::read(data), (unsigned int)SummaryRetriesField::read(data),
+                 (unsigned int)SummaryMissedField::read(data), (unsigned int)SummaryUnconfirmedField::read(data));
+        out.println(line);
+    }
+
+private:
+    uint32_t counters[COUNTER_COUNT];                // Events per counter
+    uint16_t buckets[HISTOGRAM_COUNT][BUCKET_COUNT]; // Values per bucket, saturating
+    uint64_t airtimeUs;                              // Time on air of the sent frames
+    float beaconRssi;                                // RSSI of the last accepted beacon in dBm
+    float beaconSnr;                                 // SNR of the last accepted beacon in dB
+
+    /**
+     * @brief Getter for the upper bound of a histogram bucket.
+     * @param histogram The histogram.
+     * @param bucket The bucket, any but the last.
+     * @return The first value that no longer falls into the bucket.
+     */
+    static int32_t bound(uint8_t histogram, uint8_t bucket) {
+        static const int32_t BOUNDS[HISTOGRAM_COUNT][BUCKET_COUNT - 1] = {
+            {-120, -110, -100, -90, -80, -70, -60}, // HIST_RSSI, dBm
+            {-15, -10, -5, 0, 5, 10, 15},           // HIST_SNR, dB
+            {25, 50, 100, 200, 400, 800, 1600},     // HIST_TIME_ON_AIR, ms
+            {50, 100, 200, 400, 800, 1600, 3200},   // HIST_ACK_LATENCY, ms
+            {1, 2, 5, 10, 20, 50, 100},             // HIST_SYNC_ERROR, ms
+        };
+        return BOUNDS[histogram][bucket];
+    }
+
+    /**
+     * @brief Rounds a value into the range of an int8_t.
+     * @param value The value.
+     * @return The rounded and limited value.
+     */
+    static int8_t clampInt8(float value) {
+        if (value <= -128.0f) {
+            return -128;
+        }
+        if (value >= 127.0f) {
+            return 127;
+        }
+        return (int8_t)lroundf(value);
+    }
+};
+
+#endif // LINK_METRICS_H
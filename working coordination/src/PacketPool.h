@@ -0,0 +1,250 @@
+/**
+ * @file PacketPool.h
+ * @brief This file contains the PacketPool class, a fixed set of packet buffers shared through reference-counted handles.
+ */
+
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+#include <Arduino.h>
+
+/**
+ * @class PacketPool
+ * @brief Receive buffers that are filled once by the radio and read in place by every consumer.
+ *
+ * A Packet handle keeps its buffer alive: copying a handle adds a reference and the buffer
+ * returns to the pool when the last handle is destroyed or reset. Consumers such as a logger
+ * or an uplink forwarder keep a copy of the handle instead of copying the bytes, and memory
+ * use stays bounded by POOL_SIZE whatever the packet rate. When every buffer is referenced,
+ * acquire() returns an invalid handle and the miss is counted.
+ *
+ * Reference counts are updated under a spinlock, so handles may be copied and dropped on
+ * both cores. The bytes themselves are not locked: a packet is written only while its
+ * handle is exclusive and is read-only once shared.
+ */
+class PacketPool {
+public:
+    static const size_t PACKET_SIZE = 255; // Largest LoRa payload
+    static const uint8_t POOL_SIZE = 4;    // Buffers in the pool
+
+    /**
+     * @class Packet
+     * @brief Reference-counted handle to a pool buffer.
+     */
+    class Packet {
+    public:
+        /**
+         * @brief Constructor for an invalid handle.
+         */
+        Packet() : _pool(NULL), _index(0) {}
+
+        /**
+         * @brief Copy constructor, shares the buffer.
+         * @param other The handle to share.
+         */
+        Packet(const Packet& other) : _pool(other._pool), _index(other._index) {
+            if (_pool != NULL) {
+                _pool->retain(_index);
+            }
+        }
+
+        /**
+         * @brief Destructor, returns the buffer to the pool with the last reference.
+         */
+        ~Packet() { reset(); }
+
+        /**
+         * @brief Assignment, shares the other buffer and drops the current one.
+         * @param other The handle to share.
+         * @return This handle.
+         */
+        Packet& operator=(const Packet& other) {
+            PacketPool* pool = other._pool; // Read first, other may be this handle
+            uint8_t index = other._index;
+            if (pool != NULL) {
+                pool->retain(index); // Before the release, in case both refer to the same buffer
+            }
+            reset();
+            _pool = pool;
+            _index = index;
+            return *this;
+        }
+
+        /**
+         * @brief Drops the reference and makes the handle invalid.
+         */
+        void reset() {
+            if (_pool != NULL) {
+                _pool->release(_index);
+                _pool = NULL;
+            }
+        }
+
+        /**
+         * @brief Checks whether the handle refers to a buffer.
+         * @return True for a valid handle.
+         */
+        bool isValid() const { return _pool != NULL; }
+
+        /**
+         * @brief Checks whether this is the only handle to the buffer, so it may be overwritten.
+         * @return True for a valid handle without copies.
+         */
+        bool isExclusive() const { return _pool != NULL && _pool->references(_index) == 1; }
+
+        /**
+         * @brief Accessor for the packet bytes, to be written only while the handle is exclusive.
+         * @return The buffer, PACKET_SIZE bytes.
+         */
+        uint8_t* data() { return _pool->_buffers[_index].data; }
+
+        /**
+         * @brief Accessor for the packet bytes.
+         * @return The buffer, getLength() bytes valid.
+         */
+        const uint8_t* data() const { return _pool->_buffers[_index].data; }
+
+        /**
+         * @brief Getter for the packet length.
+         * @return The number of valid bytes, 0 for an invalid handle.
+         */
+        size_t getLength() const { return _pool != NULL ? _pool->_buffers[_index].length : 0; }
+
+        /**
+         * @brief Getter for the reception time.
+         * @return The WakeScheduler::nowUs() time the packet was received, in microseconds.
+         */
+        int64_t getReceivedUs() const { return _pool != NULL ? _pool->_buffers[_index].receivedUs : 0; }
+
+        /**
+         * @brief Getter for the signal strength.
+         * @return The RSSI of the packet in dBm.
+         */
+        float getRssi() const { return _pool != NULL ? _pool->_buffers[_index].rssi : 0; }
+
+        /**
+         * @brief Getter for the signal-to-noise ratio.
+         * @return The SNR of the packet in dB.
+         */
+        float getSnr() const { return _pool != NULL ? _pool->_buffers[_index].snr : 0; }
+
+        /**
+         * @brief Records the packet length, reception time and signal after the buffer was filled.
+         * @param length The number of valid bytes, at most PACKET_SIZE.
+         * @param receivedUs The reception time in microseconds.
+         * @param rssi The RSSI in dBm.
+         * @param snr The SNR in dB.
+         */
+        void setReceived(size_t length, int64_t receivedUs, float rssi = 0, float snr = 0) {
+            Buffer& buffer = _pool->_buffers[_index];
+            buffer.length = length;
+            buffer.receivedUs = receivedUs;
+            buffer.rssi = rssi;
+            buffer.snr = snr;
+        }
+
+    private:
+        friend class PacketPool;
+
+        PacketPool* _pool; // Pool owning the buffer, NULL for an invalid handle
+        uint8_t _index;    // Buffer index in the pool
+
+        Packet(PacketPool* pool, uint8_t index) : _pool(pool), _index(index) {}
+    };
+
+    /**
+     * @brief Constructor for PacketPool, all buffers free.
+     */
+    PacketPool() : _exhausted(0) {
+        memset(_buffers, 0, sizeof(_buffers));
+    }
+
+    /**
+     * @brief Takes a free buffer.
+     * @return A handle with an empty packet, invalid if every buffer is in use.
+     */
+    Packet acquire() {
+        portENTER_CRITICAL(&lock());
+        for (uint8_t i = 0; i < POOL_SIZE; ++i) {
+            if (_buffers[i].references == 0) {
+                _buffers[i].references = 1;
+                _buffers[i].length = 0;
+                _buffers[i].receivedUs = 0;
+                _buffers[i].rssi = 0;
+                _buffers[i].snr = 0;
+                portEXIT_CRITICAL(&lock());
+                return Packet(this, i);
+            }
+        }
+        _exhausted++;
+        portEXIT_CRITICAL(&lock());
+        return Packet();
+    }
+
+    /**
+     * @brief Counts the free buffers.
+     * @return The number of buffers acquire() can still hand out.
+     */
+    uint8_t available() const {
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < POOL_SIZE; ++i) {
+            if (_buffers[i].references == 0) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * @brief Getter for the number of failed acquire() calls.
+     * @return The number of times the pool was exhausted.
+     */
+    uint32_t getExhausted() const { return _exhausted; }
+
+private:
+    PacketPool(const PacketPool&);            // Handles point into the pool, so it is never copied
+    PacketPool& operator=(const PacketPool&);
+
+    /**
+     * @struct Buffer
+     * @brief One packet and its bookkeeping.
+     */
+    struct Buffer {
+        uint8_t data[PACKET_SIZE]; // Packet bytes
+        size_t length;             // Valid bytes
+        int64_t receivedUs;        // Reception time in microseconds
+        float rssi;                // Signal strength in dBm
+        float snr;                 // Signal-to-noise ratio in dB
+        uint8_t references;        // Live handles, 0 while free
+    };
+
+    Buffer _buffers[POOL_SIZE]; // The buffers
+    uint32_t _exhausted;        // Failed acquire() calls
+
+    void retain(uint8_t index) {
+        portENTER_CRITICAL(&lock());
+        _buffers[index].references++;
+        portEXIT_CRITICAL(&lock());
+    }
+
+    void release(uint8_t index) {
+        portENTER_CRITICAL(&lock());
+        _buffers[index].references--;
+        portEXIT_CRITICAL(&lock());
+    }
+
+    uint8_t references(uint8_t index) const {
+        return _buffers[index].references;
+    }
+
+    /**
+     * @brief Spinlock guarding the reference counts, shared by both cores.
+     * @return The lock.
+     */
+    static portMUX_TYPE& lock() {
+        static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+        return mux;
+    }
+};
+
+#endif // PACKET_POOL_H
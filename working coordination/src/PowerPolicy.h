@@ -0,0 +1,128 @@
+/**
+ * @file PowerPolicy.h
+ * @brief This file contains the PowerPolicy class, which turns the battery levels of the host and its clients into longer intervals and lower output power.
+ */
+
+#ifndef POWER_POLICY_H
+#define POWER_POLICY_H
+
+#include <Arduino.h>
+#include "ClientTable.h"
+#include "Timer.h"
+
+/**
+ * @class PowerPolicy
+ * @brief Maps battery charge onto power-saving levels, so a draining fleet slows down instead of dying.
+ *
+ * Level 0 is full service. Each level below a charge threshold doubles the node's message
+ * interval and lowers the link margin AdrEngine keeps for it by MARGIN_RELIEF_DB, so the node
+ * sends less often and with less power. A node only returns to a higher level once its charge
+ * is HYSTERESIS_PERCENT above that level's threshold, so a battery that recovers in the sun or
+ * sags under load does not flip its node back and forth every cycle.
+ *
+ * The host applies its own level to the cell's interval. A client reports its charge in each
+ * ACK; the host gives a client whose level asks for a longer interval than the cell's its own
+ * schedule in the batched beacon (see BeaconBatch). A client's interval is the cell's interval
+ * times a power of two (see clientIntervalFor()), so it stays a multiple of the cell's.
+ */
+class PowerPolicy {
+public:
+    static const uint8_t BATTERY_UNKNOWN = 0xFF;   // Battery value of a node without a measurement
+    static const uint8_t LEVEL_COUNT = 4;          // Levels from full service (0) to the deepest saving
+    static const uint8_t HYSTERESIS_PERCENT = 5;   // Extra charge needed to return to the level above
+    static const int8_t MARGIN_RELIEF_DB = 2;      // Link margin given up per level
+
+    /**
+     * @brief Converts a battery reading into the value carried in ACK frames.
+     * @param percent Charge from heltec_battery_percent(), negative if unknown.
+     * @return The charge in percent, 0 to 100, or BATTERY_UNKNOWN.
+     */
+    static uint8_t toBattery(float percent) {
+        if (percent < 0) {
+            return BATTERY_UNKNOWN;
+        }
+        return percent >= 100.0f ? 100 : (uint8_t)lroundf(percent);
+    }
+
+    /**
+     * @brief Chooses the level for a new battery reading.
+     * @param battery Charge in percent, or BATTERY_UNKNOWN.
+     * @param current Level of the node so far.
+     * @return The new level, 0 for a node without a measurement.
+     */
+    static uint8_t nextLevel(uint8_t battery, uint8_t current) {
+        if (battery == BATTERY_UNKNOWN) {
+            return 0;
+        }
+        uint8_t level = 0;
+        while (level < LEVEL_COUNT - 1 && battery < threshold(level)) {
+            level++;
+        }
+        while (level < current && battery < threshold(level) + HYSTERESIS_PERCENT) {
+            level++; // Not far enough above the threshold to leave the current level
+        }
+        return level;
+    }
+
+    /**
+     * @brief Records a client's battery report and updates its level.
+     * @param entry The client's entry.
+     * @param battery Charge in percent from the client's ACK, or BATTERY_UNKNOWN.
+     */
+    static void recordBattery(ClientTable::Entry& entry, uint8_t battery) {
+        entry.battery = battery;
+        entry.powerLevel = nextLevel(battery, entry.powerLevel);
+    }
+
+    /**
+     * @brief Computes the message interval of a level.
+     * @param baseInterval Message interval at full service in seconds.
+     * @param level The level.
+     * @return The stretched interval in seconds, at most Timer::MAX_MESSAGE_INTERVAL.
+     */
+    static uint16_t intervalFor(uint16_t baseInterval, uint8_t level) {
+        uint32_t interval = (uint32_t)baseInterval << level;
+        return interval > Timer::MAX_MESSAGE_INTERVAL ? Timer::MAX_MESSAGE_INTERVAL : (uint16_t)interval;
+    }
+
+    /**
+     * @brief Computes the message interval of a client whose level is below the host's.
+     *
+     * Starts from the cell's interval as announced, which the host may have stretched beyond
+     * intervalFor(), so the result is always a whole number of the cell's cycles.
+     * @param cellInterval Message interval of the cell in seconds.
+     * @param hostLevel Level of the host.
+     * @param clientLevel Level of the client.
+     * @return The client's interval in seconds, the largest multiple of cellInterval up to Timer::MAX_MESSAGE_INTERVAL if the doubling exceeds it.
+     */
+    static uint16_t clientIntervalFor(uint16_t cellInterval, uint8_t hostLevel, uint8_t clientLevel) {
+        if (cellInterval == 0 || clientLevel <= hostLevel) {
+            return cellInterval;
+        }
+        uint32_t interval = (uint32_t)cellInterval << (clientLevel - hostLevel);
+        uint16_t limit = (uint16_t)(Timer::MAX_MESSAGE_INTERVAL / cellInterval * cellInterval);
+        return interval > limit ? limit : (uint16_t)interval;
+    }
+
+    /**
+     * @brief Computes the link margin a level gives up, passed on to AdrEngine::recordAck().
+     * @param level The level.
+     * @return The margin relief in dB.
+     */
+    static int8_t marginReliefDb(uint8_t level) {
+        return (int8_t)(level * MARGIN_RELIEF_DB);
+    }
+
+private:
+    /**
+     * @brief Getter for the charge below which a node leaves a level.
+     * @param level The level, below LEVEL_COUNT - 1.
+     * @return The threshold in percent.
+     */
+    static uint8_t threshold(uint8_t level) {
+        static const uint8_t THRESHOLDS[LEVEL_COUNT - 1] = {50, 30, 15};
+        return THRESHOLDS[level];
+    }
+};
+
+#endif // POWER_POLICY_H
@@ -0,0 +1,112 @@
+/**
+ * @file RadioConfig.h
+ * @brief This file contains the RadioConfig structure, which holds the LoRa modem settings a node was configured with.
+ */
+
+#ifndef RADIO_CONFIG_H
+#define RADIO_CONFIG_H
+
+#include <Arduino.h>
+#include <RadioLib.h>
+
+/**
+ * @struct RadioConfig
+ * @brief LoRa modem settings, kept as plain data so they can live in RTC memory.
+ */
+struct RadioConfig {
+    float frequency;          // Carrier frequency in MHz
+    float bandwidth;          // Bandwidth in kHz
+    uint8_t spreadingFactor;  // Spreading factor
+    uint8_t codingRate;       // Coding rate denominator (4/x)
+    uint8_t syncWord;         // LoRa sync word
+    int8_t outputPower;       // Transmit power in dBm
+    uint16_t preambleLength;  // Preamble length in symbols
+    float tcxoVoltage;        // TCXO reference voltage
+    bool useRegulatorLDO;     // True to use the LDO instead of the DC-DC regulator
+
+    /**
+     * @brief Applies the settings with a full radio initialization.
+     * @param radio LoRa radio object, RadioLib's SX1262 or another backend of RadioHal.h.
+     * @return RadioLib status code.
+     */
+    template <class Radio>
+    int16_t begin(Radio& radio) const {
+        return radio.begin(frequency, bandwidth, spreadingFactor, codingRate, syncWord, outputPower, preambleLength, tcxoVoltage, useRegulatorLDO);
+    }
+
+    /**
+     * @brief Reattaches to a radio that kept its configuration in warm sleep.
+     *
+     * Skips the reset, calibration and image calibration of begin(). The settings are
+     * written again through the setters, which keeps the driver's copy of them in step
+     * with the chip, since a fresh SX1262 object knows nothing about the retained state.
+     * A radio that lost its configuration reports the wrong packet type on the first
+     * setter, so a failure here means the caller should fall back to begin(). SX1262 only.
+     * @param radio LoRa radio object.
+     * @return RadioLib status code.
+     */
+    int16_t warmStart(SX1262& radio) const {
+        Module* mod = radio.getMod();
+        mod->init();
+        mod->hal->pinMode(mod->getIrq(), mod->hal->GpioModeInput);
+        mod->hal->pinMode(mod->getGpio(), mod->hal->GpioModeInput);
+
+        int16_t state = radio.standby(); // Pulling NSS low wakes the chip from warm sleep
+        RADIOLIB_ASSERT(state);
+        state = radio.setFrequency(frequency, false); // The image calibration is retained
+        RADIOLIB_ASSERT(state);
+        state = radio.setBandwidth(bandwidth);
+        RADIOLIB_ASSERT(state);
+        state = radio.setSpreadingFactor(spreadingFactor);
+        RADIOLIB_ASSERT(state);
+        state = radio.setCodingRate(codingRate);
+        RADIOLIB_ASSERT(state);
+        state = radio.setSyncWord(syncWord);
+        RADIOLIB_ASSERT(state);
+        state = radio.setOutputPower(outputPower);
+        RADIOLIB_ASSERT(state);
+        state = radio.setPreambleLength(preambleLength);
+        RADIOLIB_ASSERT(state);
+        state = radio.setCRC(2); // Same packet settings as begin()
+        RADIOLIB_ASSERT(state);
+        state = radio.invertIQ(false);
+        RADIOLIB_ASSERT(state);
+        return radio.autoLDRO();
+    }
+
+    /**
+     * @brief Computes an FNV-1a hash of the settings, used to detect configuration changes.
+     * @return The hash value.
+     */
+    uint32_t hash() const {
+        uint32_t value = 2166136261u;
+        value = mix(value, &frequency, sizeof(frequency));
+        value = mix(value, &bandwidth, sizeof(bandwidth));
+        value = mix(value, &spreadingFactor, sizeof(spreadingFactor));
+        value = mix(value, &codingRate, sizeof(codingRate));
+        value = mix(value, &syncWord, sizeof(syncWord));
+        value = mix(value, &outputPower, sizeof(outputPower));
+        value = mix(value, &preambleLength, sizeof(preambleLength));
+        value = mix(value, &tcxoVoltage, sizeof(tcxoVoltage));
+        value = mix(value, &useRegulatorLDO, sizeof(useRegulatorLDO));
+        return value;
+    }
+
+private:
+    /**
+     * @brief Folds the bytes of one field into an FNV-1a hash.
+     * @param value The running hash.
+     * @param field Pointer to the field.
+     * @param length Size of the field in bytes.
+     * @return The updated hash.
+     */
+    static uint32_t mix(uint32_t value, const void* field, size_t length) {
+        const uint8_t* bytes = (const uint8_t*)field;
+        for (size_t i = 0; i < length; ++i) {
+            value = (value ^ bytes[i]) * 16777619u;
+        }
+        return value;
+    }
+};
+
+#endif // RADIO_CONFIG_H
@@ -0,0 +1,61 @@
+/**
+ * @file RadioHal.h
+ * @brief This file describes the radio interface BasicWakeUpCoordination is written against and adapts RadioLib's SX1262 to it.
+ */
+
+#ifndef RADIO_HAL_H
+#define RADIO_HAL_H
+
+#include <Arduino.h>
+#include <RadioLib.h>
+
+/*
+ * The coordination code talks to the radio through a subset of RadioLib's SX126x interface,
+ * so RadioLib's SX1262 is a backend as it is. Another backend is a class with these members,
+ * returning RadioLib status codes:
+ *
+ *   int16_t begin(float freq, float bw, uint8_t sf, uint8_t cr, uint8_t syncWord, int8_t power,
+ *                 uint16_t preambleLength, float tcxoVoltage, bool useRegulatorLDO);
+ *   int16_t setFrequency(float freq);               // MHz
+ *   int16_t setSpreadingFactor(uint8_t sf);
+ *   int16_t setOutputPower(int8_t power);           // dBm
+ *   int16_t setPreambleLength(size_t length);       // Symbols
+ *   uint32_t getTimeOnAir(size_t length);           // Microseconds, for the current settings
+ *   int16_t startTransmit(const uint8_t* data, size_t length);
+ *   int16_t finishTransmit();                       // After the interrupt, back to standby
+ *   int16_t startReceive();
+ *   int16_t startReceiveDutyCycleAuto(uint16_t senderPreambleLength, uint16_t minSymbols);
+ *   size_t getPacketLength();
+ *   int16_t readData(uint8_t* data, size_t length);
+ *   float getRSSI();
+ *   float getSNR();
+ *   int16_t standby();
+ *   void setDio1Action(void (*action)(void));       // Called from the ISR on TX done and RX done
+ *   void clearDio1Action();
+ *
+ * and overloads of radioIrqPin() and radioHasDutyCycleRx() below. The backend is a template parameter of the
+ * coordinator, so every call is resolved at compile time and can be inlined.
+ */
+
+/**
+ * @brief Getter for the GPIO of the radio's interrupt line, used to wake from light sleep.
+ * @param radio LoRa radio object.
+ * @return The GPIO number of DIO1.
+ */
+inline uint32_t radioIrqPin(SX1262& radio) {
+    return radio.getMod()->getIrq();
+}
+
+/**
+ * @brief Checks whether the radio can sniff for a preamble in an RX duty-cycle mode.
+ *
+ * Beacons only get the long preamble such a receiver needs when the backend has one.
+ * @param radio LoRa radio object.
+ * @return True, the SX126x has startReceiveDutyCycleAuto().
+ */
+inline bool radioHasDutyCycleRx(SX1262& radio) {
+    (void)radio;
+    return true;
+}
+
+#endif // RADIO_HAL_H
@@ -0,0 +1,292 @@
+/**
+ * @file SX127xRadio.h
+ * @brief This file contains the SX127xRadio class, a radio backend for SX127x boards driven through the LoRa.h library, and the coordinator type that uses it.
+ */
+
+#ifndef SX127X_RADIO_H
+#define SX127X_RADIO_H
+
+#include <Arduino.h>
+#include <RadioLib.h>
+#include <LoRa.h>
+#include <SPI.h>
+#include "RadioHal.h"
+#include "WakeUpCoordination.h"
+
+/**
+ * @class SX127xRadio
+ * @brief Presents an SX127x on the LoRa.h API with the RadioLib-style interface of RadioHal.h.
+ *
+ * DIO0 plays the part of the SX126x DIO1: it is mapped to RX done in receive mode and to TX
+ * done for a send, and the action is attached to it directly. LoRa.h's own onReceive() and
+ * onTxDone() callbacks are not used, because its DIO0 handler reads the IRQ flags over SPI
+ * inside the interrupt. The action only wakes the coordination task, which reads and clears
+ * the flags in getPacketLength() and finishTransmit(). A frame with a bad LoRa CRC ends the
+ * receive with RADIOLIB_ERR_CRC_MISMATCH, as on the SX126x, and a wake without RX done, e.g.
+ * from a stale notification, with RADIOLIB_ERR_RX_TIMEOUT. The SX127x has no RX duty-cycle
+ * mode, so startReceiveDutyCycleAuto() keeps the receiver on and radioHasDutyCycleRx() tells
+ * the coordinator to send beacons with the regular preamble.
+ *
+ * LoRa.h drives a single radio, and so does this class.
+ */
+class SX127xRadio {
+public:
+    typedef void (*Action)(void); // Function called from the ISR on TX done and RX done, must not touch SPI
+
+    /**
+     * @brief Constructor for SX127xRadio.
+     * @param lora The LoRa.h driver, usually the global LoRa.
+     * @param ss GPIO of the SPI chip select.
+     * @param reset GPIO of the radio's reset line.
+     * @param dio0 GPIO of DIO0.
+     */
+    SX127xRadio(LoRaClass& lora, int ss, int reset, int dio0)
+        : _lora(&lora), _ss(ss), _reset(reset), _dio0(dio0), _bandwidth(125.0f), _spreadingFactor(7), _codingRate(5), _preambleLength(8), _rxState(RADIOLIB_ERR_NONE) {}
+
+    /**
+     * @brief Initializes the radio, with the arguments of RadioLib's SX1262::begin().
+     * @param freq Carrier frequency in MHz.
+     * @param bw Bandwidth in kHz.
+     * @param sf Spreading factor.
+     * @param cr Coding rate denominator (4/x).
+     * @param syncWord LoRa sync word.
+     * @param power Transmit power in dBm, 2 to 20 on the PA_BOOST pin.
+     * @param preambleLength Preamble length in symbols.
+     * @param tcxoVoltage Ignored, SX127x modules run from a crystal.
+     * @param useRegulatorLDO Ignored, the SX127x has no DC-DC regulator.
+     * @return RadioLib status code, RADIOLIB_ERR_CHIP_NOT_FOUND if the radio did not answer.
+     */
+    int16_t begin(float freq, float bw, uint8_t sf, uint8_t cr, uint8_t syncWord, int8_t power, uint16_t preambleLength, float tcxoVoltage = 0, bool useRegulatorLDO = false) {
+        (void)tcxoVoltage;
+        (void)useRegulatorLDO;
+        _lora->setPins(_ss, _reset, _dio0);
+        if (!_lora->begin((long)(freq * 1000000.0f))) {
+            return RADIOLIB_ERR_CHIP_NOT_FOUND;
+        }
+        _bandwidth = bw;
+        _lora->setSignalBandwidth((long)(bw * 1000.0f));
+        setSpreadingFactor(sf);
+        _codingRate = cr;
+        _lora->setCodingRate4(cr);
+        _lora->setSyncWord(syncWord);
+        setOutputPower(power);
+        setPreambleLength(preambleLength);
+        _lora->enableCrc(); // Same packet settings as RadioLib's begin()
+        return RADIOLIB_ERR_NONE;
+    }
+
+    int16_t setFrequency(float freq) {
+        _lora->setFrequency((long)(freq * 1000000.0f));
+        return RADIOLIB_ERR_NONE;
+    }
+
+    int16_t setSpreadingFactor(uint8_t sf) {
+        if (sf < 6 || sf > 12) {
+            return RADIOLIB_ERR_INVALID_SPREADING_FACTOR;
+        }
+        _spreadingFactor = sf;
+        _lora->setSpreadingFactor(sf); // Also sets the low data rate optimization
+        return RADIOLIB_ERR_NONE;
+    }
+
+    int16_t setOutputPower(int8_t power) {
+        if (power < 2 || power > 20) {
+            return RADIOLIB_ERR_INVALID_OUTPUT_POWER;
+        }
+        _lora->setTxPower(power);
+        return RADIOLIB_ERR_NONE;
+    }
+
+    int16_t setPreambleLength(size_t length) {
+        _preambleLength = (uint16_t)length;
+        _lora->setPreambleLength((long)length);
+        return RADIOLIB_ERR_NONE;
+    }
+
+    /**
+     * @brief Computes the time on air with the Semtech formula: explicit header, CRC on, LDRO above 16 ms symbols.
+     * @param length Payload length in bytes.
+     * @return The time on air in microseconds.
+     */
+    uint32_t getTimeOnAir(size_t length) const {
+        float symbolUs = 1000.0f * (float)(1UL << _spreadingFactor) / _bandwidth;
+        int lowDataRate = symbolUs > 16000.0f ? 1 : 0;
+        int numerator = 8 * (int)length - 4 * _spreadingFactor + 28 + 16;
+        int denominator = 4 * (_spreadingFactor - 2 * lowDataRate);
+        int blocks = numerator > 0 ? (numerator + denominator - 1) / denominator : 0;
+        float symbols = (_preambleLength + 4.25f) + 8 + blocks * _codingRate;
+        return (uint32_t)(symbols * symbolUs);
+    }
+
+    /**
+     * @brief Starts sending a frame; the action is called once it left the radio.
+     * @param data The frame.
+     * @param length The length of the frame.
+     * @return RadioLib status code, RADIOLIB_ERR_TX_TIMEOUT if a frame is still on air.
+     */
+    int16_t startTransmit(const uint8_t* data, size_t length) {
+        if (!_lora->beginPacket()) {
+            return RADIOLIB_ERR_TX_TIMEOUT;
+        }
+        _lora->write(data, length);
+        writeRegister(REG_DIO_MAPPING_1, DIO0_TX_DONE); // LoRa.h only maps it with its own callback set
+        _lora->endPacket(true); // Asynchronous, DIO0 signals TX done
+        return RADIOLIB_ERR_NONE;
+    }
+
+    /**
+     * @brief Ends a send after the interrupt, clearing TX done and returning to standby.
+     * @return RadioLib status code, RADIOLIB_ERR_TX_TIMEOUT if the frame has not left the radio.
+     */
+    int16_t finishTransmit() {
+        uint8_t flags = readRegister(REG_IRQ_FLAGS);
+        writeRegister(REG_IRQ_FLAGS, flags);
+        _lora->idle();
+        return (flags & IRQ_TX_DONE) != 0 ? RADIOLIB_ERR_NONE : RADIOLIB_ERR_TX_TIMEOUT;
+    }
+
+    int16_t startReceive() {
+        _rxState = RADIOLIB_ERR_NONE;
+        _lora->receive(); // Maps DIO0 to RX done
+        return RADIOLIB_ERR_NONE;
+    }
+
+    int16_t startReceiveDutyCycleAuto(uint16_t senderPreambleLength = 8, uint16_t minSymbols = 8) {
+        (void)senderPreambleLength;
+        (void)minSymbols;
+        return startReceive();
+    }
+
+    /**
+     * @brief Getter for the length of the received frame, read from the IRQ flags.
+     *
+     * Runs in the task after the interrupt; this also picks up a frame whose interrupt was
+     * missed, e.g. while the ISR was detached for light sleep.
+     * @return The length in bytes, 0 if no frame or one with a bad CRC was received; readData() then reports the error.
+     */
+    size_t getPacketLength() {
+        uint8_t flags = readRegister(REG_IRQ_FLAGS);
+        if ((flags & IRQ_RX_DONE) == 0) {
+            _rxState = RADIOLIB_ERR_RX_TIMEOUT; // Woken without a frame
+            return 0;
+        }
+        if ((flags & IRQ_CRC_ERROR) != 0) {
+            writeRegister(REG_IRQ_FLAGS, IRQ_RX_DONE | IRQ_CRC_ERROR);
+            _rxState = RADIOLIB_ERR_CRC_MISMATCH; // parsePacket() would drop the frame without a trace
+            return 0;
+        }
+        return (size_t)_lora->parsePacket(); // Clears the flags and points the FIFO at the frame
+    }
+
+    /**
+     * @brief Reads the frame found by getPacketLength().
+     * @param data Buffer for the frame.
+     * @param length Number of bytes to read.
+     * @return RadioLib status code, RADIOLIB_ERR_CRC_MISMATCH for a frame with a bad CRC, RADIOLIB_ERR_RX_TIMEOUT without a frame.
+     */
+    int16_t readData(uint8_t* data, size_t length) {
+        if (_rxState != RADIOLIB_ERR_NONE) {
+            int16_t state = _rxState;
+            _rxState = RADIOLIB_ERR_NONE;
+            return state;
+        }
+        size_t i = 0;
+        while (i < length && _lora->available()) {
+            data[i++] = (uint8_t)_lora->read();
+        }
+        return RADIOLIB_ERR_NONE;
+    }
+
+    float getRSSI() { return (float)_lora->packetRssi(); }
+    float getSNR() { return _lora->packetSnr(); }
+
+    int16_t standby() {
+        _lora->idle();
+        return RADIOLIB_ERR_NONE;
+    }
+
+    /**
+     * @brief Puts the radio to sleep, the SX127x keeps its registers.
+     * @param retainConfig Ignored, the configuration is always retained.
+     * @return RadioLib status code.
+     */
+    int16_t sleep(bool retainConfig = true) {
+        (void)retainConfig;
+        _lora->sleep();
+        return RADIOLIB_ERR_NONE;
+    }
+
+    /**
+     * @brief Attaches the action to DIO0, in place of LoRa.h's SPI-reading handler.
+     * @param action IRAM_ATTR function that only wakes a task, e.g. with vTaskNotifyGiveFromISR().
+     */
+    void setDio1Action(Action action) {
+        attachInterrupt(digitalPinToInterrupt(_dio0), action, RISING);
+    }
+
+    void clearDio1Action() {
+        detachInterrupt(digitalPinToInterrupt(_dio0));
+    }
+
+    /**
+     * @brief Getter for the GPIO of DIO0.
+     * @return The GPIO number.
+     */
+    int getDio0Pin() const { return _dio0; }
+
+private:
+    static const uint8_t REG_IRQ_FLAGS = 0x12;      // IRQ flags, cleared by writing ones
+    static const uint8_t REG_DIO_MAPPING_1 = 0x40;  // Mapping of DIO0 to DIO3
+    static const uint8_t IRQ_TX_DONE = 0x08;        // TX done flag
+    static const uint8_t IRQ_CRC_ERROR = 0x20;      // Payload CRC error flag
+    static const uint8_t IRQ_RX_DONE = 0x40;        // RX done flag
+    static const uint8_t DIO0_TX_DONE = 0x40;       // DIO0 mapped to TX done
+    static const uint32_t SPI_FREQUENCY = 8000000;  // SPI clock LoRa.h uses by default
+
+    LoRaClass* _lora;         // LoRa.h driver
+    int _ss;                  // GPIO of the SPI chip select
+    int _reset;               // GPIO of the reset line
+    int _dio0;                // GPIO of DIO0
+    float _bandwidth;         // Bandwidth in kHz
+    uint8_t _spreadingFactor; // Spreading factor
+    uint8_t _codingRate;      // Coding rate denominator (4/x)
+    uint16_t _preambleLength; // Preamble length in symbols
+    int16_t _rxState;         // Error getPacketLength() found for readData() to report, RADIOLIB_ERR_NONE if none
+
+    // LoRa.h keeps its register access private, so the flags are read on the same bus and settings
+    uint8_t readRegister(uint8_t address) { return transferRegister(address & 0x7F, 0x00); }
+    void writeRegister(uint8_t address, uint8_t value) { transferRegister(address | 0x80, value); }
+
+    uint8_t transferRegister(uint8_t address, uint8_t value) {
+        digitalWrite(_ss, LOW);
+        SPI.beginTransaction(SPISettings(SPI_FREQUENCY, MSBFIRST, SPI_MODE0));
+        SPI.transfer(address);
+        uint8_t response = SPI.transfer(value);
+        SPI.endTransaction();
+        digitalWrite(_ss, HIGH);
+        return response;
+    }
+};
+
+/**
+ * @brief Getter for the GPIO of the radio's interrupt line, used to wake from light sleep.
+ * @param radio LoRa radio object.
+ * @return The GPIO number of DIO0.
+ */
+inline uint32_t radioIrqPin(SX127xRadio& radio) {
+    return (uint32_t)radio.getDio0Pin();
+}
+
+/**
+ * @brief Checks whether the radio can sniff for a preamble in an RX duty-cycle mode.
+ * @param radio LoRa radio object.
+ * @return False, the SX127x keeps its receiver on and beacons use the regular preamble.
+ */
+inline bool radioHasDutyCycleRx(SX127xRadio& radio) {
+    (void)radio;
+    return false;
+}
+
+typedef BasicWakeUpCoordination<SX127xRadio> SX127xWakeUpCoordination; // Coordinator for SX127x boards on LoRa.h
+
+#endif // SX127X_RADIO_H
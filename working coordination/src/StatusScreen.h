@@ -0,0 +1,118 @@
+#ifndef STATUS_SCREEN_H // Prevents multiple inclusions of this header file
+#define STATUS_SCREEN_H
+
+#include <Arduino.h> // Includes the Arduino core library
+#include <OLEDDisplay.h> // Includes the OLED driver base class used by heltec_unofficial
+
+// StatusScreen class definition
+// Line-based text screen on top of an OLEDDisplay that only does I2C work when the text changes.
+// The last text of every line is cached; setting a line to the same text costs nothing, and a
+// changed line is erased and redrawn in the framebuffer alone. The framebuffer is pushed by
+// flush(), at most once per refresh interval, so a burst of updates costs a single transfer.
+// Use it from the one task that owns the display.
+class StatusScreen {
+public:
+    static const uint8_t LINE_COUNT = 6; // Lines of the 10 px font on a 64 px display
+    static const uint8_t LINE_HEIGHT = 10; // Height of a line in pixels
+    static const uint8_t GLYPH_HEIGHT = 13; // Height of the 10 px font including descenders
+    static const size_t LINE_LENGTH = 32; // Characters per line, including the terminator
+    static const uint32_t DEFAULT_REFRESH_MS = 100; // Minimum interval between two framebuffer pushes
+
+    // Constructor, the display must be initialized before the first flush
+    StatusScreen(OLEDDisplay& display, uint32_t refreshMs = DEFAULT_REFRESH_MS)
+        : display(display), refreshMs(refreshMs), lastFlushMs(0), flushed(false), dirty(false), pushes(0), skipped(0) {
+        memset(lines, 0, sizeof(lines));
+    }
+
+    // Sets the text of one line, redrawing it in the framebuffer only if it changed
+    void setLine(uint8_t line, const char* text) {
+        if (line >= LINE_COUNT) {
+            return;
+        }
+        if (text == NULL) {
+            text = "";
+        }
+        if (strncmp(lines[line], text, LINE_LENGTH - 1) == 0) {
+            skipped++;
+            return;
+        }
+        strncpy(lines[line], text, LINE_LENGTH - 1);
+        lines[line][LINE_LENGTH - 1] = '\0';
+
+        // Glyphs are taller than a line, so the neighbours are redrawn where the erase cut into them
+        display.setColor(BLACK);
+        display.fillRect(0, line * LINE_HEIGHT, display.getWidth(), GLYPH_HEIGHT);
+        display.setColor(WHITE);
+        uint8_t first = line > 0 ? line - 1 : line;
+        uint8_t last = line + 1 < LINE_COUNT ? line + 1 : line;
+        for (uint8_t i = first; i <= last; ++i) {
+            display.drawString(0, i * LINE_HEIGHT, lines[i]);
+        }
+        dirty = true;
+    }
+
+    // Shows count lines from the top and blanks the lines below them
+    void setLines(const char (*text)[LINE_LENGTH], uint8_t count) {
+        for (uint8_t i = 0; i < LINE_COUNT; ++i) {
+            setLine(i, i < count ? text[i] : "");
+        }
+    }
+
+    // Blanks every line
+    void clear() {
+        setLines(NULL, 0);
+    }
+
+    // Pushes the framebuffer if a line changed and the refresh interval has passed, returns true if it did
+    bool flush(bool force = false) {
+        if (!dirty) {
+            return false;
+        }
+        if (!force && msUntilFlush() > 0) {
+            return false;
+        }
+        display.display();
+        lastFlushMs = millis();
+        flushed = true;
+        dirty = false;
+        pushes++;
+        return true;
+    }
+
+    // Time until a pending change may be pushed, 0 if it may be pushed now or nothing is pending
+    uint32_t msUntilFlush() const {
+        if (!dirty || !flushed) {
+            return 0;
+        }
+        uint32_t elapsed = millis() - lastFlushMs;
+        return elapsed < refreshMs ? refreshMs - elapsed : 0;
+    }
+
+    // Returns true if a change is waiting for flush()
+    bool isDirty() const { return dirty; }
+
+    // Forgets the cached text after something else drew on or cleared the display
+    void invalidate() {
+        memset(lines, 0, sizeof(lines));
+        display.clear();
+        dirty = true;
+    }
+
+    // Returns the number of framebuffer pushes
+    uint32_t getPushes() const { return pushes; }
+
+    // Returns the number of line updates skipped because the text was unchanged
+    uint32_t getSkipped() const { return skipped; }
+
+private:
+    OLEDDisplay& display; // Display the lines are drawn on
+    uint32_t refreshMs; // Minimum interval between pushes
+    char lines[LINE_COUNT][LINE_LENGTH]; // Text currently in the framebuffer
+    unsigned long lastFlushMs; // millis() of the last push
+    bool flushed; // True once a push happened, so the first one is never delayed
+    bool dirty; // True if the framebuffer differs from the display
+    uint32_t pushes; // Framebuffer pushes
+    uint32_t skipped; // Unchanged line updates
+};
+
+#endif // STATUS_SCREEN_H
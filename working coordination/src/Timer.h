@@ -0,0 +1,350 @@
+/**
+ * @file Timer.h
+ * @brief This file contains the definition of the Timer class, which is used to manage timing intervals, wait times, and sleep states for LoRa communication.
+ */
+
+#ifndef TIMER_H // Prevents multiple inclusions of this header file
+#define TIMER_H
+
+#include <Arduino.h> // Includes the Arduino core library
+#include "Crc16.h"   // Includes the CRC-16 used as frame checksum
+#include "FrameLayout.h" // Includes the compile-time frame field descriptions
+
+/**
+ * @class Timer
+ * @brief Manages timing intervals, wait times, and sleep states for LoRa communication.
+ *
+ * A sync frame is 11 bytes: header, epoch, packed schedule, packed data rate and channel,
+ * checksum. The TDMA slot count and length follow the data rate only when the header carries
+ * HEADER_FLAG_SLOTS, which adds 2 bytes; batched beacons always carry them (see BeaconBatch).
+ */
+class Timer {
+public:
+    typedef FrameField<0, 1> HeaderField;                       // Frame type and version
+    typedef NextField<HeaderField, 4> EpochField;               // 32-bit epoch seconds
+    typedef NextField<EpochField, 3> ScheduleField;             // Packed schedule, see packSchedule()
+    typedef NextField<ScheduleField, 1> RateField;              // Spreading factor and channel of the next cycle, see packRate()
+    typedef NextField<RateField, 1> SlotCountField;             // TDMA slots after the beacon, only with HEADER_FLAG_SLOTS
+    typedef NextField<SlotCountField, 1> SlotLengthField;       // TDMA slot length in 10 ms units, only with HEADER_FLAG_SLOTS
+    typedef FrameField<0, 2> ChecksumField;                     // CRC-16 over all preceding bytes, relative to the end of the payload
+
+    static const uint8_t FRAME_VERSION = 6;         // Wire format version carried in the frame header
+    static const uint8_t HEADER_FLAG_SLOTS = 0x80;  // Header bit set when the slot fields follow the data rate
+    static const uint8_t FRAME_TYPE_SYNC = 1;       // Frame type of a serialized Timer
+    static const uint8_t FRAME_TYPE_ACK = 2;        // Frame type of a client acknowledgement
+    static const uint8_t FRAME_TYPE_ACK_CONFIRM = 3; // Frame type of the host's confirmation of an ACK
+    static const uint8_t FRAME_TYPE_BATCH = 4;      // Frame type of a Timer followed by per-node schedules
+    static const size_t PAYLOAD_SIZE = RateField::END;        // Bytes covered by the checksum of a frame without slots
+    static const size_t SLOTS_PAYLOAD_SIZE = SlotLengthField::END; // Bytes covered by the checksum of a frame with slots
+    static const size_t SERIALIZED_SIZE = SLOTS_PAYLOAD_SIZE + ChecksumField::SIZE; // Largest sync frame, with slots
+    static const uint16_t MAX_MESSAGE_INTERVAL = 0x3FFF; // Largest message interval that fits in 14 bits
+    static const uint16_t MAX_WAIT_TIME = 0xFF;     // Largest wait time that fits in 8 bits
+    static const size_t TIME_STRING_SIZE = 20;      // "YYYY-MM-DD HH:MM:SS" plus terminator
+    static const uint8_t MAX_SPREADING_FACTOR = 0x0F; // Largest spreading factor that fits in 4 bits
+    static const uint8_t CHANNEL_UNCHANGED = 0x0F;  // Channel value that keeps the current channel, also the number of positions that fit in 4 bits
+
+    /**
+     * @brief Constructor that initializes the Timer object with provided values.
+     *
+     * Values outside the range of the wire format are clamped.
+     * @param currentTime The current time.
+     * @param messageInterval The interval between messages.
+     * @param waitTime The wait time before sending the next message.
+     * @param sleepState The sleep state of the device.
+     * @param slotCount The number of TDMA slots following the beacon, 0 for none.
+     * @param slotLength The length of each TDMA slot in 10 ms units.
+     * @param spreadingFactor The spreading factor the cell switches to after this cycle, 0 to keep the current one.
+     * @param channel Position in the cell's sub-band of the channel the cell switches to after this cycle (see ChannelPlan::positionOf()), CHANNEL_UNCHANGED to keep the current one.
+     */
+    Timer(time_t currentTime, uint16_t messageInterval, uint16_t waitTime, uint8_t sleepState, uint8_t slotCount = 0, uint8_t slotLength = 0, uint8_t spreadingFactor = 0, uint8_t channel = CHANNEL_UNCHANGED)
+        : currentTime(currentTime),
+          messageInterval(clamp(messageInterval, MAX_MESSAGE_INTERVAL)),
+          waitTime(clamp(waitTime, MAX_WAIT_TIME)),
+          sleepState(sleepState & 0x03),
+          slotCount(slotCount),
+          slotLength(slotLength),
+          spreadingFactor(clamp(spreadingFactor, MAX_SPREADING_FACTOR)),
+          channel(clamp(channel, CHANNEL_UNCHANGED)) {}
+
+    /**
+     * @brief Constructor that initializes the Timer object from a serialized data array.
+     * @param data The serialized data array.
+     * @param length The number of bytes available in the data array.
+     */
+    Timer(const uint8_t* data, size_t length = SERIALIZED_SIZE) {
+        if (!deserialize(data, length)) {
+            // Handle deserialization error (e.g., log an error, set default values, etc.)
+            currentTime = 0;
+            messageInterval = 0;
+            waitTime = 0;
+            sleepState = 0;
+            slotCount = 0;
+            slotLength = 0;
+            spreadingFactor = 0;
+            channel = CHANNEL_UNCHANGED;
+        }
+    }
+
+    /**
+     * @brief Getter for the current time.
+     * @return The current time.
+     */
+    time_t getCurrentTime() const { return currentTime; }
+
+    /**
+     * @brief Getter for the message interval.
+     * @return The message interval.
+     */
+    uint16_t getMessageInterval() const { return messageInterval; }
+
+    /**
+     * @brief Getter for the wait time.
+     * @return The wait time.
+     */
+    uint16_t getWaitTime() const { return waitTime; }
+
+    /**
+     * @brief Getter for the sleep state.
+     * @return The sleep state.
+     */
+    uint8_t getSleepState() const { return sleepState; }
+
+    /**
+     * @brief Getter for the number of TDMA slots following the beacon.
+     * @return The slot count.
+     */
+    uint8_t getSlotCount() const { return slotCount; }
+
+    /**
+     * @brief Getter for the TDMA slot length.
+     * @return The slot length in 10 ms units.
+     */
+    uint8_t getSlotLength() const { return slotLength; }
+
+    /**
+     * @brief Getter for the spreading factor of the next cycle.
+     * @return The spreading factor, 0 if unchanged.
+     */
+    uint8_t getSpreadingFactor() const { return spreadingFactor; }
+
+    /**
+     * @brief Getter for the channel of the next cycle.
+     * @return The channel's position in the cell's sub-band, CHANNEL_UNCHANGED if unchanged.
+     */
+    uint8_t getChannel() const { return channel; }
+
+    /**
+     * @brief Formats a time value as "YYYY-MM-DD HH:MM:SS" without heap allocation.
+     * @param timeVal The time value to format.
+     * @param buffer The buffer to write into, at least TIME_STRING_SIZE bytes.
+     * @param size The size of the buffer.
+     * @return The length written, 0 with an empty string if the buffer is too small.
+     */
+    static size_t formatTime(time_t timeVal, char* buffer, size_t size) {
+        struct tm tm_info;
+        localtime_r(&timeVal, &tm_info);
+        size_t length = strftime(buffer, size, "%Y-%m-%d %H:%M:%S", &tm_info);
+        if (length == 0 && size > 0) {
+            buffer[0] = '\0';
+        }
+        return length;
+    }
+
+    /**
+     * @brief Builds a frame header byte from a frame type and the current wire format version.
+     * @param type The frame type, 3 bits.
+     * @param slots True if the slot fields follow, see HEADER_FLAG_SLOTS.
+     * @return The header byte.
+     */
+    static uint8_t makeHeader(uint8_t type, bool slots = false) {
+        return (uint8_t)(((type & 0x07) << 4) | (slots ? HEADER_FLAG_SLOTS : 0) | FRAME_VERSION);
+    }
+
+    /**
+     * @brief Extracts the frame type from a header byte.
+     * @param header The header byte.
+     * @return The frame type.
+     */
+    static uint8_t headerType(uint8_t header) { return (header >> 4) & 0x07; }
+
+    /**
+     * @brief Extracts the wire format version from a header byte.
+     * @param header The header byte.
+     * @return The wire format version.
+     */
+    static uint8_t headerVersion(uint8_t header) { return header & 0x0F; }
+
+    /**
+     * @brief Packs a schedule into the 24-bit field used by the wire format.
+     * @param messageInterval The message interval, at most MAX_MESSAGE_INTERVAL.
+     * @param waitTime The wait time, at most MAX_WAIT_TIME.
+     * @param sleepState The sleep state, 2 bits.
+     * @return messageInterval in bits 0-13, waitTime in bits 14-21 and sleepState in bits 22-23.
+     */
+    static uint32_t packSchedule(uint16_t messageInterval, uint16_t waitTime, uint8_t sleepState) {
+        return (uint32_t)(messageInterval & MAX_MESSAGE_INTERVAL) | ((uint32_t)(waitTime & MAX_WAIT_TIME) << 14) | ((uint32_t)(sleepState & 0x03) << 22);
+    }
+
+    /**
+     * @brief Unpacks a 24-bit schedule field.
+     * @param packed The packed field.
+     * @param messageInterval Set to the message interval.
+     * @param waitTime Set to the wait time.
+     * @param sleepState Set to the sleep state.
+     */
+    static void unpackSchedule(uint32_t packed, uint16_t& messageInterval, uint16_t& waitTime, uint8_t& sleepState) {
+        messageInterval = packed & MAX_MESSAGE_INTERVAL;
+        waitTime = (packed >> 14) & MAX_WAIT_TIME;
+        sleepState = (packed >> 22) & 0x03;
+    }
+
+    /**
+     * @brief Packs the spreading factor and channel of the next cycle into the 8-bit rate field.
+     * @param spreadingFactor The spreading factor, 0 if unchanged.
+     * @param channel The channel's position in the sub-band, CHANNEL_UNCHANGED if unchanged.
+     * @return spreadingFactor in bits 0-3 and channel in bits 4-7.
+     */
+    static uint8_t packRate(uint8_t spreadingFactor, uint8_t channel) {
+        return (uint8_t)((spreadingFactor & MAX_SPREADING_FACTOR) | ((channel & CHANNEL_UNCHANGED) << 4));
+    }
+
+    /**
+     * @brief Writes the header and the Timer fields without a checksum.
+     *
+     * The layout is given by the field typedefs from HeaderField to RateField, followed by
+     * SlotCountField and SlotLengthField if slots is set. Frames that extend the Timer append
+     * their data after the returned number of bytes.
+     * @param data The data array to write into, at least SLOTS_PAYLOAD_SIZE bytes.
+     * @param type The frame type written into the header.
+     * @param slots True to write the slot fields and set HEADER_FLAG_SLOTS.
+     * @return The number of bytes written, PAYLOAD_SIZE or SLOTS_PAYLOAD_SIZE.
+     */
+    size_t writePayload(uint8_t* data, uint8_t type, bool slots) const {
+        HeaderField::write(data, makeHeader(type, slots));
+        EpochField::write(data, (uint32_t)currentTime);
+        ScheduleField::write(data, packSchedule(messageInterval, waitTime, sleepState));
+        RateField::write(data, packRate(spreadingFactor, channel));
+        if (!slots) {
+            return PAYLOAD_SIZE;
+        }
+        SlotCountField::write(data, slotCount);
+        SlotLengthField::write(data, slotLength);
+        return SLOTS_PAYLOAD_SIZE;
+    }
+
+    /**
+     * @brief Reads the Timer fields written by writePayload(), without checking the frame type or checksum.
+     * @param data The data array, at least as long as the header announces.
+     * @return The number of bytes read, PAYLOAD_SIZE or SLOTS_PAYLOAD_SIZE.
+     */
+    size_t readPayload(const uint8_t* data) {
+        currentTime = (time_t)EpochField::read(data);
+        unpackSchedule(ScheduleField::read(data), messageInterval, waitTime, sleepState);
+        uint8_t rate = (uint8_t)RateField::read(data);
+        spreadingFactor = rate & MAX_SPREADING_FACTOR;
+        channel = rate >> 4;
+        if (!hasSlots(HeaderField::read(data))) {
+            slotCount = 0;
+            slotLength = 0;
+            return PAYLOAD_SIZE;
+        }
+        slotCount = SlotCountField::read(data);
+        slotLength = SlotLengthField::read(data);
+        return SLOTS_PAYLOAD_SIZE;
+    }
+
+    /**
+     * @brief Checks whether a header announces the slot fields.
+     * @param header The header byte.
+     * @return True if HEADER_FLAG_SLOTS is set.
+     */
+    static bool hasSlots(uint8_t header) { return (header & HEADER_FLAG_SLOTS) != 0; }
+
+    /**
+     * @brief Serializes the Timer object into a data array with checksum.
+     *
+     * Layout: the bytes of writePayload() followed by the checksum. The slot fields are
+     * only sent if the Timer has slots.
+     * @param data The data array to serialize into, at least SERIALIZED_SIZE bytes.
+     * @return The number of bytes written.
+     */
+    size_t serialize(uint8_t* data) const {
+        size_t length = writePayload(data, FRAME_TYPE_SYNC, slotCount > 0);
+        ChecksumField::write(data + length, calculateChecksum(data, length)); // Adds checksum to the data array
+        return length + ChecksumField::SIZE;
+    }
+
+    /**
+     * @brief Deserializes the Timer object from a data array and verifies header and checksum.
+     * @param data The serialized data array.
+     * @param length The number of bytes available in the data array.
+     * @return True if deserialization is successful, false otherwise.
+     */
+    bool deserialize(const uint8_t* data, size_t length = SERIALIZED_SIZE) {
+        if (length < PAYLOAD_SIZE + ChecksumField::SIZE) {
+            return false; // Too short
+        }
+        uint8_t header = (uint8_t)HeaderField::read(data);
+        size_t payloadSize = hasSlots(header) ? SLOTS_PAYLOAD_SIZE : PAYLOAD_SIZE;
+        if (header != makeHeader(FRAME_TYPE_SYNC, hasSlots(header)) || length < payloadSize + ChecksumField::SIZE) {
+            return false; // Not a sync frame of this version, or too short for its slot fields
+        }
+        if (readChecksum(data, payloadSize) != calculateChecksum(data, payloadSize)) {
+            return false; // Checksum mismatch, data is corrupted
+        }
+
+        readPayload(data);
+        return true; // Data is valid
+    }
+
+    /**
+     * @brief Calculates the CRC-16/CCITT checksum for the given data array.
+     * @param data The data array to calculate the checksum for.
+     * @param length The length of the data array.
+     * @return The calculated checksum.
+     */
+    static uint16_t calculateChecksum(const uint8_t* data, size_t length) {
+        return crc16(data, length);
+    }
+
+    /**
+     * @brief Reads the checksum stored in a serialized Timer.
+     * @param data The serialized data array.
+     * @param payloadSize The bytes before the checksum, PAYLOAD_SIZE or SLOTS_PAYLOAD_SIZE.
+     * @return The stored checksum.
+     */
+    static uint16_t readChecksum(const uint8_t* data, size_t payloadSize) {
+        return (uint16_t)ChecksumField::read(data + payloadSize);
+    }
+
+private:
+    /**
+     * @brief Limits a value to the given maximum.
+     * @param value The value to limit.
+     * @param limit The maximum allowed value.
+     * @return The limited value.
+     */
+    static uint16_t clamp(uint16_t value, uint16_t limit) { return value > limit ? limit : value; }
+
+    /**
+     * @brief Limits an 8-bit value to the given maximum.
+     * @param value The value to limit.
+     * @param limit The maximum allowed value.
+     * @return The limited value.
+     */
+    static uint8_t clamp(uint8_t value, uint8_t limit) { return value > limit ? limit : value; }
+
+    time_t currentTime;        // Stores the current time
+    uint16_t messageInterval;  // Stores the message interval
+    uint16_t waitTime;         // Stores the wait time
+    uint8_t sleepState;        // Stores the sleep state (2-bit value)
+    uint8_t slotCount;         // Stores the number of TDMA slots
+    uint8_t slotLength;        // Stores the TDMA slot length in 10 ms units
+    uint8_t spreadingFactor;   // Stores the spreading factor of the next cycle
+    uint8_t channel;           // Stores the channel of the next cycle as its position in the sub-band
+};
+
+static_assert(Timer::PAYLOAD_SIZE + Timer::ChecksumField::SIZE == 11, "A sync frame without slots is 11 bytes on air");
+static_assert(Timer::SERIALIZED_SIZE == 13, "A sync frame with slots is 13 bytes on air");
+
+#endif // TIMER_H
@@ -0,0 +1,159 @@
+/**
+ * @file WakeScheduler.h
+ * @brief This file contains the WakeScheduler class, which computes microsecond wake times and learns the clock drift between host and client.
+ */
+
+#ifndef WAKE_SCHEDULER_H
+#define WAKE_SCHEDULER_H
+
+#include <Arduino.h>
+#include <sys/time.h>
+
+/**
+ * @class WakeScheduler
+ * @brief Tracks the last sync point and corrects each sleep for drift and boot latency.
+ *
+ * The class has no constructor so that an instance can be kept in RTC memory
+ * across deep sleep. Call reset() after a normal boot.
+ */
+class WakeScheduler {
+public:
+    static const int32_t MAX_DRIFT_PPM = 20000;   // Larger deviations are treated as a missed cycle, not drift
+    static const int64_t MAX_BOOT_LEAD_US = 2000000; // Upper bound on the measured wake-to-sync latency
+    static const uint8_t FILTER_WEIGHT = 4;        // Weight of the running average (1/FILTER_WEIGHT per sample)
+
+    /**
+     * @brief Returns the RTC-backed system time in microseconds, which keeps counting through deep sleep.
+     * @return The current time in microseconds.
+     */
+    static int64_t nowUs() {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+    }
+
+    /**
+     * @brief Clears the sync point and the learned corrections.
+     */
+    void reset() {
+        anchorUs = 0;
+        intervalUs = 0;
+        wakeTargetUs = 0;
+        expectedSyncUs = 0;
+        bootLeadUs = 0;
+        driftPpm = 0;
+        driftSamples = 0;
+        hasAnchor = false;
+    }
+
+    /**
+     * @brief Records how late the node became ready after the last scheduled wake.
+     *
+     * Call this once when coordination starts after a timer wakeup.
+     */
+    void markAwake() {
+        if (wakeTargetUs == 0) {
+            return;
+        }
+
+        int64_t lead = nowUs() - wakeTargetUs;
+        wakeTargetUs = 0;
+        if (lead < 0 || lead > MAX_BOOT_LEAD_US) {
+            return;
+        }
+
+        bootLeadUs = (bootLeadUs == 0) ? lead : bootLeadUs + (lead - bootLeadUs) / FILTER_WEIGHT;
+    }
+
+    /**
+     * @brief Records a sync point and, if requested, updates the drift estimate from the previous one.
+     * @param syncUs Local time of the sync event in microseconds.
+     * @param newIntervalUs Cycle interval in microseconds announced with this sync.
+     * @param learnDrift True on the client, which follows the host's clock; false on the host.
+     */
+    void synchronize(int64_t syncUs, int64_t newIntervalUs, bool learnDrift) {
+        if (learnDrift && hasAnchor && newIntervalUs == intervalUs && intervalUs > 0) {
+            int64_t elapsed = syncUs - anchorUs;
+            int64_t cycles = (elapsed + intervalUs / 2) / intervalUs; // Whole cycles between the two syncs
+            if (cycles > 0) {
+                int64_t nominal = cycles * intervalUs;
+                int64_t errorPpm = (elapsed - nominal) * 1000000LL / nominal;
+                if (errorPpm >= -MAX_DRIFT_PPM && errorPpm <= MAX_DRIFT_PPM) {
+                    if (driftSamples == 0) {
+                        driftPpm = (int32_t)errorPpm;
+                    } else {
+                        driftPpm += (int32_t)((errorPpm - driftPpm) / FILTER_WEIGHT);
+                    }
+                    if (driftSamples < 0xFF) {
+                        driftSamples++;
+                    }
+                }
+            }
+        }
+
+        anchorUs = syncUs;
+        intervalUs = newIntervalUs;
+        hasAnchor = true;
+    }
+
+    /**
+     * @brief Computes how long to sleep so the node is ready a guard time before the next sync.
+     *
+     * Cycles that already passed are skipped, so the result always lies in the future.
+     * @param guardUs Time to be awake before the expected sync, in microseconds.
+     * @return Sleep duration in microseconds, 0 if no sync point is known.
+     */
+    uint64_t scheduleWake(int64_t guardUs) {
+        if (!hasAnchor || intervalUs <= 0) {
+            return 0;
+        }
+
+        int64_t localIntervalUs = intervalUs + intervalUs * driftPpm / 1000000LL; // Host interval in local clock units
+        int64_t now = nowUs();
+        int64_t sync = anchorUs + localIntervalUs;
+        while (sync - guardUs - bootLeadUs <= now) {
+            sync += localIntervalUs;
+        }
+
+        int64_t target = sync - guardUs - bootLeadUs;
+        wakeTargetUs = target;
+        expectedSyncUs = sync;
+        return (uint64_t)(target - now);
+    }
+
+    /**
+     * @brief Getter for the learned drift.
+     * @return The local clock deviation from the host in parts per million.
+     */
+    int32_t getDriftPpm() const { return driftPpm; }
+
+    /**
+     * @brief Getter for the learned boot latency.
+     * @return The time from a scheduled wake to coordination start in microseconds.
+     */
+    int64_t getBootLeadUs() const { return bootLeadUs; }
+
+    /**
+     * @brief Getter for the predicted time of the next sync.
+     * @return The local time of the sync the last scheduleWake() call targeted, 0 if none.
+     */
+    int64_t getExpectedSyncUs() const { return expectedSyncUs; }
+
+    /**
+     * @brief Checks whether a sync point has been recorded.
+     * @return True if a sync point is known.
+     */
+    bool isSynchronized() const { return hasAnchor; }
+
+private:
+    int64_t anchorUs;       // Local time of the last sync in microseconds
+    int64_t intervalUs;     // Cycle interval of the last sync in microseconds
+    int64_t wakeTargetUs;   // Local time the node was scheduled to wake at
+    int64_t expectedSyncUs; // Local time the next sync is predicted at
+    int64_t bootLeadUs;     // Averaged latency between wake and coordination start
+    int32_t driftPpm;       // Averaged local clock deviation from the host
+    uint8_t driftSamples;   // Number of drift samples taken so far
+    bool hasAnchor;         // True once a sync point has been recorded
+};
+
+#endif // WAKE_SCHEDULER_H
@@ -0,0 +1,1034 @@
+/**
+ * @file WakeUpCoordination.h
+ * @brief This file contains the BasicWakeUpCoordination class template, which coordinates wake-up and sleep cycles for LoRa communication between a host and client device.
+ */
+
+#ifndef WAKE_UP_COORDINATION_H
+#define WAKE_UP_COORDINATION_H
+
+#include <Arduino.h>
+#include <RadioLib.h>
+#include "esp_sleep.h"
+#include "Timer.h"
+#include "WakeScheduler.h"
+#include "ClientTable.h"
+#include "CoordinationState.h"
+#include "AdrEngine.h"
+#include "BeaconBatch.h"
+#include "PacketPool.h"
+#include "AirtimeGovernor.h"
+#include "PowerPolicy.h"
+#include "RadioHal.h"
+
+/**
+ * @class BasicWakeUpCoordination
+ * @brief Manages the wake-up coordination between host and client devices using LoRa communication.
+ *
+ * The radio backend is a template parameter, so the calls into it are resolved at compile
+ * time. Any type with the interface described in RadioHal.h works; WakeUpCoordination is the
+ * coordinator for RadioLib's SX1262, SX127xWakeUpCoordination (see SX127xRadio.h) the one for
+ * SX127x boards driven through LoRa.h.
+ * @tparam Radio The radio backend.
+ */
+template <class Radio>
+class BasicWakeUpCoordination {
+public:
+    /**
+     * @brief Constructor for BasicWakeUpCoordination.
+     * @param pool Pool the received frames are stored in.
+     * @param nodeId Identifier this node uses in ACK frames and for its TDMA slot.
+     */
+    BasicWakeUpCoordination(PacketPool& pool, uint16_t nodeId = 0) : _pool(&pool), _packetFunction(NULL), _nodeId(nodeId), _txState(RADIOLIB_ERR_NONE), _txTimeoutMs(0), _txBeacon(false), _txStartUs(0), _txTimeOnAirUs(0), _txWaitUs(0), _lightSleep(false), _ackMetrics(false), _battery(PowerPolicy::BATTERY_UNKNOWN), _messageInterval(BASE_MESSAGE_INTERVAL), _waitTime(HOST_WAIT_TIME), _joinSlots(HOST_JOIN_SLOTS), _retrySlots(HOST_RETRY_SLOTS) {}
+
+    /**
+     * @brief Derives a 16-bit node identifier from the chip's MAC address.
+     * @return The node identifier.
+     */
+    static uint16_t defaultNodeId() {
+        uint64_t mac = ESP.getEfuseMac();
+        return (uint16_t)(mac ^ (mac >> 16) ^ (mac >> 32));
+    }
+
+    /**
+     * @brief Setter for the node identifier.
+     * @param nodeId Identifier this node uses in ACK frames and for its TDMA slot.
+     */
+    void setNodeId(uint16_t nodeId) { _nodeId = nodeId; }
+
+    /**
+     * @brief Setter for the function that sees every received frame.
+     *
+     * The function gets the pooled packet itself; a consumer that needs the frame later,
+     * such as a logger or an uplink forwarder, keeps a copy of the handle rather than of the
+     * bytes and must not modify them. It runs in the radio task, so it should not block.
+     * @param packetFunction Function called with each received frame, NULL for none.
+     */
+    void setPacketFunction(void (*packetFunction)(const PacketPool::Packet&)) { _packetFunction = packetFunction; }
+
+    /**
+     * @brief Setter for light sleep while waiting for a packet.
+     *
+     * With light sleep, the ESP32 sleeps between beacons with the radio left in RX, and wakes
+     * on the DIO1 GPIO or a timer at the end of the wait. Both cores stop, so the display task
+     * only catches up once the waiting task wakes. Waking takes about a millisecond, which is
+     * added to the reception time of the packet; this is meant for the host, whose waits last
+     * whole resend intervals while it looks for clients.
+     * @param enabled True to light-sleep during waits, false to block the task at full clock.
+     */
+    void setLightSleep(bool enabled) { _lightSleep = enabled; }
+
+    /**
+     * @brief Setter for piggybacking the link summary on ACK frames.
+     *
+     * A client appends LinkMetrics::SUMMARY_SIZE bytes to each ACK: the quality of the last
+     * beacon it accepted and its error counters. A host accepts ACKs with and without the
+     * summary and prints each summary it receives, so the downlink of every client shows up
+     * next to the uplink the host measures itself.
+     * @param enabled True to append the summary to this node's ACKs.
+     */
+    void setAckMetrics(bool enabled) { _ackMetrics = enabled; }
+
+    /**
+     * @brief Setter for the battery charge of this node, measured once per wake.
+     *
+     * A client reports it in its ACKs; a host derives its own power-saving level from it
+     * and stretches the cell's interval (see PowerPolicy).
+     * @param percent Charge from heltec_battery_percent(), negative if unknown.
+     */
+    void setBatteryPercent(float percent) { _battery = PowerPolicy::toBattery(percent); }
+
+    /**
+     * @brief Setter for the schedule a host announces to its cell, BASE_MESSAGE_INTERVAL and HOST_WAIT_TIME by default.
+     *
+     * The interval is the one at full battery, PowerPolicy stretches it while batteries drain.
+     * A cycle must outlast the beacon and its slot window, which at a high spreading factor
+     * takes several seconds; a host stretches a shorter interval to fit and says so on Serial.
+     * @param messageInterval Seconds between two cycles, at most Timer::MAX_MESSAGE_INTERVAL.
+     * @param waitTime Wait time announced in the beacon in seconds.
+     */
+    void setCellSchedule(uint16_t messageInterval, uint8_t waitTime) {
+        _messageInterval = messageInterval < Timer::MAX_MESSAGE_INTERVAL ? messageInterval : Timer::MAX_MESSAGE_INTERVAL;
+        _waitTime = waitTime;
+    }
+
+    /**
+     * @brief Setter for the contention slots a host announces around the assigned ones, HOST_JOIN_SLOTS and HOST_RETRY_SLOTS by default.
+     *
+     * A cell that only ever has a few nodes needs fewer of them; each slot lengthens the window.
+     * @param joinSlots Join slots before the assigned ones, at least 1 so new nodes can register.
+     * @param retrySlots Retry slots after the assigned ones.
+     */
+    void setContentionSlots(uint8_t joinSlots, uint8_t retrySlots) {
+        _joinSlots = joinSlots > 0 ? joinSlots : 1;
+        _retrySlots = retrySlots;
+        if ((uint16_t)_joinSlots + _retrySlots > MAX_CONTENTION_SLOTS) {
+            _retrySlots = (uint8_t)(MAX_CONTENTION_SLOTS - _joinSlots); // Every client must still get a slot
+        }
+    }
+
+    /**
+     * @brief Identifies the node that sent a frame.
+     * @param data The received frame.
+     * @param length The length of the received frame.
+     * @return The client's node ID for an ACK, 0 for frames sent by a host.
+     */
+    static uint16_t senderOf(const uint8_t* data, size_t length) {
+        if ((length == ACK_SIZE || length == ACK_METRICS_SIZE) && Timer::headerType(data[0]) == Timer::FRAME_TYPE_ACK) {
+            return (uint16_t)AckNodeField::read(data);
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Coordinates the wake-up and sleep cycles.
+     *
+     * A node whose state is warm from the previous cycle only listens around the expected
+     * beacon (client) or sends a bounded number of beacons (host) instead of a full re-sync.
+     * @param state Coordination state kept in RTC memory across deep sleep.
+     * @param isHost Boolean indicating if the device is a host.
+     * @param radio LoRa radio object.
+     * @param ledFunction Function pointer to control the LED.
+     * @param displayFunction Function pointer to control the display, called with two lines of text.
+     * @return Sleep duration in microseconds.
+     */
+    uint64_t coordinate(CoordinationState& state, bool isHost, Radio& radio, void (*ledFunction)(int), void (*displayFunction)(const char*, const char*)) {
+        _ledFunction = ledFunction;
+        _displayFunction = displayFunction;
+        _state = &state;
+        _scheduler = &state.scheduler;
+        _scheduler->markAwake();
+        _receiveTask = xTaskGetCurrentTaskHandle(); // Task to wake from the DIO1 interrupt
+        radio.setDio1Action(onDio1);
+
+        bool warm = state.isWarm();
+        Timer timer = state.getSchedule();
+        uint64_t sleepDuration;
+        if (isHost) {
+            sleepDuration = hostCoordinate(timer, state.clients, radio, warm);
+        } else {
+            sleepDuration = clientCoordinate(timer, radio, warm);
+        }
+        state.setSchedule(timer);
+
+        // Both sides switch to the data rate and channel the beacon announced; a client that
+        // lost the cell waits at the base rate on the home channel
+        uint8_t spreadingFactor = timer.getSpreadingFactor();
+        uint8_t channel = state.channels.channelAt(timer.getChannel());
+        if (!isHost && state.missedWarmWindows > 0) {
+            spreadingFactor = state.baseSpreadingFactor;
+            channel = state.channels.homeChannel();
+        }
+        applySpreadingFactor(radio, spreadingFactor);
+        applyChannel(radio, channel);
+        return sleepDuration;
+    }
+
+private:
+    static const size_t DATA_SIZE = BeaconBatch::MAX_SIZE; // Size of the largest beacon
+    typedef FrameField<0, 1> AckHeaderField;                // ACK and ACK confirm frames: frame type and version
+    typedef NextField<AckHeaderField, 2> AckChecksumField;  // Checksum of the acknowledged Timer
+    typedef NextField<AckChecksumField, 2> AckNodeField;    // Identifier of the acknowledging client
+    typedef NextField<AckNodeField, 1> AckPowerField;       // Output power used, or commanded by the confirmation
+    typedef NextField<AckPowerField, 1> AckBatteryField;    // Sender's battery charge in percent, PowerPolicy::BATTERY_UNKNOWN if none
+    static const size_t ACK_SIZE = AckBatteryField::END;    // Size of an ACK or ACK confirm frame
+    static const size_t ACK_METRICS_SIZE = ACK_SIZE + LinkMetrics::SUMMARY_SIZE; // Size of an ACK with the link summary appended
+    static const uint8_t ACK_MAX_ATTEMPTS = 4;         // ACKs a client sends before giving up on a confirmation
+    static const uint32_t ACK_TURNAROUND_MS = 50;      // Allowance for the host to turn an ACK into a confirmation
+    static const uint8_t ACK_BACKOFF_MAX_EXPONENT = 3; // Retries pick among up to 2^3 contention slots
+    static const uint8_t HOST_JOIN_SLOTS = 2;          // Default contention slots before the assigned ones, for nodes joining the cell
+    static const uint8_t HOST_RETRY_SLOTS = 2;         // Default contention slots after the assigned ones, for retries
+    static const uint8_t MAX_CONTENTION_SLOTS = 0xFF - ClientTable::MAX_CLIENTS; // Join and retry slots that leave room for every client
+    static const uint32_t HOST_RESEND_INTERVAL = 1100; // Minimum interval between host beacons in milliseconds
+    static const uint16_t BASE_MESSAGE_INTERVAL = 10;  // Default message interval of the cell at full battery in seconds
+    static const uint8_t HOST_WAIT_TIME = 5;           // Default wait time announced in the beacon in seconds
+    static const uint32_t WAIT_FOREVER = 0xFFFFFFFF;   // Timeout value that blocks until a packet arrives
+    static const int64_t CLIENT_GUARD_US = 50000;      // Client listens this long before the expected beacon
+    static const uint8_t HOST_WARM_BEACONS = 3;        // Beacons a warm host sends before giving up on its clients
+    static const size_t DISPLAY_LINE_SIZE = 32;        // Stack buffer for one formatted display line
+    static const uint16_t BEACON_PREAMBLE_LENGTH = 32; // Beacon preamble in symbols, long enough for duty-cycled listening, if the radio has it
+    static const uint16_t CAD_MIN_SYMBOLS = 8;         // Preamble symbols a duty-cycled receiver needs to lock on
+    static const uint32_t TX_DONE_MARGIN_MS = 100;     // Allowance on top of the time on air before a TX counts as lost
+    static const int ERR_AIRTIME_EXHAUSTED = -1100;    // Status of a frame the airtime budget kept off the air
+    static TaskHandle_t _receiveTask; // Task notified by the DIO1 interrupt
+    PacketPool* _pool; // Pool the received frames are stored in
+    void (*_packetFunction)(const PacketPool::Packet&); // Function called with each received frame
+    uint16_t _nodeId; // Identifier of this node
+    void (*_ledFunction)(int); // Function pointer for LED control
+    void (*_displayFunction)(const char*, const char*); // Function pointer for display control
+    CoordinationState* _state; // State kept across deep sleep
+    WakeScheduler* _scheduler; // Scheduler used to compute the next wake time
+    int _txState;              // Result of the last startTransmitFrame() call
+    uint32_t _txTimeoutMs;     // Time the frame on air may take before TX done counts as lost
+    bool _txBeacon;            // True while a beacon with the long preamble is on air
+    int64_t _txStartUs;        // esp_timer_get_time() when the frame on air was started
+    uint32_t _txTimeOnAirUs;   // Time on air of the frame on air
+    int64_t _txWaitUs;         // Time until the last frame held back would have fit into the airtime budget
+    bool _lightSleep;          // True to light-sleep while waiting for a packet
+    bool _ackMetrics;          // True to append the link summary to ACKs
+    uint8_t _battery;          // Battery charge of this node in percent, PowerPolicy::BATTERY_UNKNOWN if unknown
+    uint16_t _messageInterval; // Message interval a host announces at full battery in seconds
+    uint8_t _waitTime;         // Wait time a host announces in seconds
+    uint8_t _joinSlots;        // Join slots a host announces
+    uint8_t _retrySlots;       // Retry slots a host announces
+
+    /**
+     * @struct SentMessageInfo
+     * @brief Structure to hold the send time and checksum.
+     */
+    struct SentMessageInfo {
+        int64_t sendTimeUs;     // Time the message transmission started, in microseconds
+        uint16_t checksum;      // Checksum of the sent message
+    };
+
+    SentMessageInfo lastSentMessage; // Instance of SentMessageInfo
+
+    /**
+     * @brief DIO1 interrupt handler, wakes the coordination task.
+     */
+    static void IRAM_ATTR onDio1() {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        if (_receiveTask != NULL) {
+            vTaskNotifyGiveFromISR(_receiveTask, &higherPriorityTaskWoken);
+        }
+        portYIELD_FROM_ISR(higherPriorityTaskWoken);
+    }
+
+    /**
+     * @brief Receives a packet, blocking the task on the DIO1 interrupt instead of polling the radio.
+     *
+     * The radio's FIFO is read straight into a pool buffer, which is the only copy of the frame.
+     * The packet's buffer is reused while the caller holds the only handle to it; once shared, the
+     * packet is left to its other holders and a fresh buffer is taken from the pool.
+     * @param radio LoRa radio object.
+     * @param packet Set to the received packet, its length is 0 unless a frame was stored.
+     * @param timeoutMs Maximum time to wait in milliseconds, or WAIT_FOREVER.
+     * @param dutyCycle True to sniff for a beacon preamble in the radio's RX duty-cycle mode, sleeping
+     *        between checks, instead of keeping the receiver on. Only for frames sent with BEACON_PREAMBLE_LENGTH.
+     *        A backend without one (see radioHasDutyCycleRx()) keeps the receiver on.
+     * @return RadioLib status code, RADIOLIB_ERR_RX_TIMEOUT if nothing arrived in time,
+     *         RADIOLIB_ERR_MEMORY_ALLOCATION_FAILED if every pool buffer is held elsewhere.
+     */
+    int receivePacket(Radio& radio, PacketPool::Packet& packet, uint32_t timeoutMs, bool dutyCycle = false) {
+        if (!packet.isExclusive()) {
+            packet = _pool->acquire();
+            if (!packet.isValid()) {
+                return RADIOLIB_ERR_MEMORY_ALLOCATION_FAILED;
+            }
+        }
+        packet.setReceived(0, 0);
+
+        ulTaskNotifyTake(pdTRUE, 0); // Drop a stale notification left by a previous TX done
+
+        int state = dutyCycle && radioHasDutyCycleRx(radio) ? radio.startReceiveDutyCycleAuto(BEACON_PREAMBLE_LENGTH, CAD_MIN_SYMBOLS) : radio.startReceive();
+        if (state != RADIOLIB_ERR_NONE) {
+            return state;
+        }
+
+        TickType_t ticks = (timeoutMs == WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+        bool received = _lightSleep ? lightSleepUntilDio1(radio, timeoutMs) : ulTaskNotifyTake(pdTRUE, ticks) != 0;
+        if (!received) {
+            radio.standby();
+            return RADIOLIB_ERR_RX_TIMEOUT;
+        }
+        int64_t receivedUs = WakeScheduler::nowUs();
+
+        size_t packetLength = radio.getPacketLength();
+        if (packetLength > PacketPool::PACKET_SIZE) {
+            packetLength = PacketPool::PACKET_SIZE; // Truncate packets larger than the buffer
+        }
+        state = radio.readData(packet.data(), packetLength);
+        if (state == RADIOLIB_ERR_NONE && packetLength == 0) {
+            state = RADIOLIB_ERR_RX_TIMEOUT; // Woken without a frame, which no caller can use
+        }
+        if (state == RADIOLIB_ERR_NONE) {
+            packet.setReceived(packetLength, receivedUs, radio.getRSSI(), radio.getSNR());
+            _state->metrics.recordReceived(packet.getRssi(), packet.getSnr());
+            if (_packetFunction != NULL) {
+                _packetFunction(packet);
+            }
+        } else {
+            _state->metrics.count(LinkMetrics::RECEIVE_ERRORS);
+        }
+        return state;
+    }
+
+    /**
+     * @brief Starts sending a frame and returns while it is on air.
+     *
+     * The radio copies the frame into its own buffer, so the caller's buffer may be reused at
+     * once. Every started frame must be ended with finishTransmitFrame(), which sleeps until the
+     * DIO1 TX done interrupt. Work done in between overlaps with the time on air.
+     *
+     * A frame that does not fit into the airtime budget of the sub-band is not started. Every
+     * frame belongs to a slot or window that passes long before the budget frees up, so it is
+     * dropped rather than deferred; _txWaitUs says when it would have fit.
+     * @param radio LoRa radio object.
+     * @param data The frame to send.
+     * @param length The length of the frame.
+     * @param beacon True to send the frame with the long beacon preamble.
+     * @param priority Share of the airtime budget the frame may use.
+     * @return RadioLib status code, ERR_AIRTIME_EXHAUSTED if the budget kept the frame off the air.
+     */
+    int startTransmitFrame(Radio& radio, const uint8_t* data, size_t length, bool beacon, AirtimeGovernor::Priority priority) {
+        ulTaskNotifyTake(pdTRUE, 0); // Drop a stale notification, the next one must be this TX done
+
+        int64_t timeOnAirUs = beacon ? beaconTimeOnAirUs(radio, length) : (int64_t)radio.getTimeOnAir(length);
+        _txTimeOnAirUs = (uint32_t)timeOnAirUs;
+        _txWaitUs = _state->airtime.waitUs(_state->channels.subBand, _txTimeOnAirUs, priority, WakeScheduler::nowUs());
+        if (_txWaitUs > 0) {
+            _state->metrics.count(LinkMetrics::FRAMES_HELD_BACK);
+            _txState = ERR_AIRTIME_EXHAUSTED;
+            return _txState;
+        }
+        _txTimeoutMs = (uint32_t)(timeOnAirUs / 1000) + TX_DONE_MARGIN_MS;
+        _txBeacon = beacon && radioHasDutyCycleRx(radio); // Nobody sniffs for the long preamble otherwise
+        if (_txBeacon) {
+            radio.setPreambleLength(BEACON_PREAMBLE_LENGTH);
+        }
+        _txStartUs = esp_timer_get_time();
+        _txState = radio.startTransmit(data, length);
+        return _txState;
+    }
+
+    /**
+     * @brief Waits for the frame started by startTransmitFrame() to leave the radio.
+     *
+     * The task sleeps on the DIO1 notification instead of polling, so the radio can be put
+     * back into receive mode as soon as the interrupt fires.
+     * @param radio LoRa radio object.
+     * @return RadioLib status code, RADIOLIB_ERR_TX_TIMEOUT if TX done never fired,
+     *         ERR_AIRTIME_EXHAUSTED if the frame was never started.
+     */
+    int finishTransmitFrame(Radio& radio) {
+        int state = _txState;
+        if (state == ERR_AIRTIME_EXHAUSTED) {
+            return state; // Nothing went on air
+        }
+        if (state == RADIOLIB_ERR_NONE && ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(_txTimeoutMs)) == 0) {
+            state = RADIOLIB_ERR_TX_TIMEOUT;
+        }
+        _state->trace.recordSince(CycleTrace::PHASE_TX, _txStartUs);
+        int finishState = radio.finishTransmit(); // Clears the interrupt flags and returns to standby
+        if (state == RADIOLIB_ERR_NONE) {
+            state = finishState;
+        }
+        _state->metrics.recordSent(_txTimeOnAirUs, state == RADIOLIB_ERR_NONE);
+        _state->airtime.commit(_state->channels.subBand, _txTimeOnAirUs, WakeScheduler::nowUs()); // A timed-out frame may still have gone out
+        if (_txBeacon) {
+            radio.setPreambleLength(_state->radio.preambleLength); // ACKs and confirmations keep the short preamble
+            _txBeacon = false;
+        }
+        return state;
+    }
+
+    /**
+     * @brief Starts sending an ACK or ACK confirm frame for a Timer checksum.
+     *
+     * End the frame with finishTransmitFrame().
+     * @param radio LoRa radio object.
+     * @param type Frame type, Timer::FRAME_TYPE_ACK or Timer::FRAME_TYPE_ACK_CONFIRM.
+     * @param checksum Checksum of the acknowledged Timer.
+     * @param nodeId Identifier of the acknowledging client.
+     * @param power Output power the ACK is sent with, or the power commanded by the confirmation.
+     * @param priority Share of the airtime budget the frame may use.
+     * @param withSummary True to append this node's link summary.
+     * @return RadioLib status code.
+     */
+    int startAckFrame(Radio& radio, uint8_t type, uint16_t checksum, uint16_t nodeId, int8_t power, AirtimeGovernor::Priority priority, bool withSummary = false) {
+        uint8_t ackData[ACK_METRICS_SIZE];
+        AckHeaderField::write(ackData, Timer::makeHeader(type));
+        AckChecksumField::write(ackData, checksum);
+        AckNodeField::write(ackData, nodeId);
+        AckPowerField::write(ackData, (uint8_t)power);
+        AckBatteryField::write(ackData, _battery);
+        if (withSummary) {
+            _state->metrics.writeSummary(ackData + ACK_SIZE);
+        }
+        return startTransmitFrame(radio, ackData, withSummary ? ACK_METRICS_SIZE : ACK_SIZE, false, priority);
+    }
+
+    /**
+     * @brief Checks whether a frame is an ACK or ACK confirm frame for the given checksum.
+     * @param data The received frame.
+     * @param length The length of the received frame.
+     * @param type Expected frame type.
+     * @param checksum Expected Timer checksum.
+     * @param nodeId Set to the node ID carried by the frame.
+     * @param power Set to the output power carried by the frame.
+     * @param battery Set to the sender's battery charge carried by the frame.
+     * @param summary Set to the appended link summary, NULL if the frame carries none. May be NULL.
+     * @return True if the frame matches.
+     */
+    static bool parseAckFrame(const uint8_t* data, size_t length, uint8_t type, uint16_t checksum, uint16_t& nodeId, int8_t& power, uint8_t& battery, const uint8_t** summary = NULL) {
+        if ((length != ACK_SIZE && length != ACK_METRICS_SIZE) || AckHeaderField::read(data) != Timer::makeHeader(type) ||
+            AckChecksumField::read(data) != checksum) {
+            return false;
+        }
+        nodeId = (uint16_t)AckNodeField::read(data);
+        power = (int8_t)AckPowerField::read(data);
+        battery = (uint8_t)AckBatteryField::read(data);
+        if (summary != NULL) {
+            *summary = length == ACK_METRICS_SIZE ? data + ACK_SIZE : NULL;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Switches the radio and the stored settings to a new spreading factor.
+     * @param radio LoRa radio object.
+     * @param spreadingFactor The new spreading factor, 0 to keep the current one.
+     */
+    void applySpreadingFactor(Radio& radio, uint8_t spreadingFactor) {
+        if (spreadingFactor == 0 || spreadingFactor == _state->radio.spreadingFactor) {
+            return;
+        }
+        if (radio.setSpreadingFactor(spreadingFactor) == RADIOLIB_ERR_NONE) {
+            _state->radio.spreadingFactor = spreadingFactor;
+            Serial.print("Switched to SF");
+            Serial.println(spreadingFactor);
+        }
+    }
+
+    /**
+     * @brief Tunes the radio and the stored settings to a new channel of the cell's sub-band.
+     * @param radio LoRa radio object.
+     * @param channel The new channel, ChannelPlan::NO_CHANNEL to keep the current one.
+     */
+    void applyChannel(Radio& radio, uint8_t channel) {
+        if (channel == _state->channel || !_state->channels.contains(channel)) {
+            return; // Also covers NO_CHANNEL, which no sub-band contains
+        }
+        float frequency = _state->channels.frequencyOf(channel);
+        if (radio.setFrequency(frequency) == RADIOLIB_ERR_NONE) {
+            _state->channel = channel;
+            _state->radio.frequency = frequency;
+            Serial.print("Switched to channel ");
+            Serial.println(channel);
+        }
+    }
+
+    /**
+     * @brief Switches the radio and the stored settings to a new output power.
+     * @param radio LoRa radio object.
+     * @param power The new output power in dBm.
+     */
+    void applyOutputPower(Radio& radio, int8_t power) {
+        if (power == _state->radio.outputPower) {
+            return;
+        }
+        if (radio.setOutputPower(power) == RADIOLIB_ERR_NONE) {
+            _state->radio.outputPower = power;
+        }
+    }
+
+    /**
+     * @brief Maps a node ID onto one of the join slots.
+     * @param nodeId Identifier of the node.
+     * @param slotCount Number of join slots.
+     * @return The slot index.
+     */
+    static uint8_t slotForNode(uint16_t nodeId, uint8_t slotCount) {
+        uint32_t hash = (uint32_t)nodeId * 2654435761u; // Spreads neighbouring IDs across slots
+        return slotCount == 0 ? 0 : (uint8_t)((hash >> 16) % slotCount);
+    }
+
+    /**
+     * @brief Finds a contention slot, skipping the slots assigned to registered clients.
+     * @param slots Slot layout of the beacon.
+     * @param slotCount Number of slots.
+     * @param first First slot that may be picked.
+     * @param index Number of contention slots to skip from there, wrapping around the ones left.
+     * @return The slot index, slotCount if no contention slot is left.
+     */
+    static uint8_t contentionSlot(const BeaconBatch::SlotPlan& slots, uint8_t slotCount, uint8_t first, uint8_t index) {
+        uint8_t remaining = 0;
+        for (uint16_t slot = first; slot < slotCount; ++slot) {
+            if (slots.isContention((uint8_t)slot)) {
+                remaining++;
+            }
+        }
+        if (remaining == 0) {
+            return slotCount;
+        }
+        index %= remaining;
+        for (uint16_t slot = first; slot < slotCount; ++slot) {
+            if (slots.isContention((uint8_t)slot) && index-- == 0) {
+                return (uint8_t)slot;
+            }
+        }
+        return slotCount;
+    }
+
+    /**
+     * @brief Computes the TDMA slot length that fits an ACK and its confirmation.
+     *
+     * The slot fits the ACK with the link summary appended, whether or not the clients send it.
+     * @param radio LoRa radio object.
+     * @return The slot length in 10 ms units.
+     */
+    static uint8_t slotLengthFor(Radio& radio) {
+        uint32_t slotMs = radio.getTimeOnAir(ACK_METRICS_SIZE) / 1000 + radio.getTimeOnAir(ACK_SIZE) / 1000 + ACK_TURNAROUND_MS;
+        uint32_t units = (slotMs + 9) / 10;
+        return units > 0xFF ? 0xFF : (uint8_t)units;
+    }
+
+    /**
+     * @brief Checks whether a received frame is a beacon.
+     * @param data The received frame.
+     * @param length The length of the received frame.
+     * @return True for a Timer or a batched beacon.
+     */
+    static bool isBeacon(const uint8_t* data, size_t length) {
+        if (length == 0) {
+            return false;
+        }
+        uint8_t type = Timer::headerType(data[0]);
+        return type == Timer::FRAME_TYPE_SYNC || type == Timer::FRAME_TYPE_BATCH;
+    }
+
+    /**
+     * @brief Light-sleeps until DIO1 goes high or the timeout passes, with the radio left receiving.
+     *
+     * The DIO1 interrupt is detached while asleep: the GPIO wakeup needs a level trigger, which
+     * would fire continuously once the pin is high. Each wake restores the rising-edge interrupt
+     * and checks the pin level, so a packet that arrives during the sleep is not missed.
+     * @param radio LoRa radio object, in RX.
+     * @param timeoutMs Maximum time to wait in milliseconds, or WAIT_FOREVER.
+     * @return True if DIO1 signalled a packet, false on timeout.
+     */
+    bool lightSleepUntilDio1(Radio& radio, uint32_t timeoutMs) {
+        gpio_num_t dio1 = (gpio_num_t)radioIrqPin(radio);
+        int64_t deadlineUs = esp_timer_get_time() + (int64_t)timeoutMs * 1000LL;
+        while (true) {
+            if (ulTaskNotifyTake(pdTRUE, 0) != 0 || digitalRead(dio1) == HIGH) {
+                return true;
+            }
+            if (timeoutMs != WAIT_FOREVER) {
+                int64_t remainingUs = deadlineUs - esp_timer_get_time();
+                if (remainingUs <= 0) {
+                    return false;
+                }
+                esp_sleep_enable_timer_wakeup((uint64_t)remainingUs);
+            }
+            radio.clearDio1Action();
+            gpio_wakeup_enable(dio1, GPIO_INTR_HIGH_LEVEL);
+            esp_sleep_enable_gpio_wakeup();
+            Serial.flush(); // The UART stops in light sleep
+            esp_light_sleep_start();
+            gpio_wakeup_disable(dio1);
+            esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL); // A timer left armed would cut the deep sleep short
+            radio.setDio1Action(onDio1);
+        }
+    }
+
+    /**
+     * @brief Computes the time on air of a beacon, which uses a longer preamble than the other frames if the radio has duty-cycle RX.
+     * @param radio LoRa radio object, configured with the regular preamble.
+     * @param length The length of the beacon.
+     * @return The beacon time on air in microseconds.
+     */
+    int64_t beaconTimeOnAirUs(Radio& radio, size_t length) const {
+        int64_t symbolUs = (int64_t)(1000.0f * (1 << _state->radio.spreadingFactor) / _state->radio.bandwidth);
+        int64_t extraSymbols = radioHasDutyCycleRx(radio) ? (int64_t)BEACON_PREAMBLE_LENGTH - _state->radio.preambleLength : 0;
+        return (int64_t)radio.getTimeOnAir(length) + extraSymbols * symbolUs;
+    }
+
+    /**
+     * @brief Computes the interval between two beacons of the same cycle.
+     *
+     * A beacon is only resent once its whole slot window has passed.
+     * @param radio LoRa radio object.
+     * @param timer The beacon's Timer.
+     * @param length The length of the beacon.
+     * @return The beacon period in milliseconds.
+     */
+    uint32_t beaconPeriodMs(Radio& radio, const Timer& timer, size_t length) const {
+        uint32_t windowMs = (uint32_t)(beaconTimeOnAirUs(radio, length) / 1000) + (uint32_t)timer.getSlotCount() * timer.getSlotLength() * 10;
+        return windowMs + ACK_TURNAROUND_MS > HOST_RESEND_INTERVAL ? windowMs + ACK_TURNAROUND_MS : HOST_RESEND_INTERVAL;
+    }
+
+    /**
+     * @brief Blocks until the given local time.
+     * @param targetUs Local time in microseconds.
+     */
+    static void waitUntil(int64_t targetUs) {
+        int64_t remaining = targetUs - WakeScheduler::nowUs();
+        if (remaining > 0) {
+            delay((unsigned long)((remaining + 999) / 1000));
+        }
+    }
+
+    /**
+     * @enum AckResult
+     * @brief Outcome of a client acknowledgement exchange.
+     */
+    enum AckResult {
+        ACK_CONFIRMED,   // The host confirmed the ACK
+        ACK_UNCONFIRMED, // No confirmation arrived within the allowed attempts
+        ACK_SUPERSEDED   // A newer Timer arrived and is waiting in the receive buffer
+    };
+
+    /**
+     * @brief Sends an ACK in this node's TDMA slot and waits for the host's confirmation.
+     *
+     * A registered client sends in the slot the beacon assigned it. A node the beacon does not
+     * list picks a join slot from its ID and the beacon's checksum, so two nodes that collide
+     * once are unlikely to collide again on the next beacon. A retry moves to a random later
+     * contention slot, one of the next 2^attempt (bounded exponential backoff measured in
+     * slots), and never into a slot assigned to another client. When no slot is left, the
+     * client listens until the host's next beacon would be due, so a resent beacon replaces
+     * the current one instead of being lost.
+     * @param radio LoRa radio object.
+     * @param timer The Timer being acknowledged.
+     * @param slots Slot layout of the beacon being acknowledged.
+     * @param checksum Checksum of the Timer being acknowledged.
+     * @param beaconEndUs Local time the beacon reception completed, start of the slot window.
+     * @param beaconLength Length of the beacon being acknowledged.
+     * @param packet Receive packet, holds the newer Timer on ACK_SUPERSEDED.
+     * @param commandedPower Set to the output power the host commanded on ACK_CONFIRMED.
+     * @return The outcome of the exchange.
+     */
+    AckResult acknowledge(Radio& radio, const Timer& timer, const BeaconBatch::SlotPlan& slots, uint16_t checksum, int64_t beaconEndUs, size_t beaconLength, PacketPool::Packet& packet, int8_t& commandedPower) {
+        uint32_t confirmTimeout = radio.getTimeOnAir(ACK_SIZE) / 1000 + ACK_TURNAROUND_MS;
+        uint8_t slotCount = timer.getSlotCount();
+        int64_t slotUs = (int64_t)timer.getSlotLength() * 10000LL;
+        uint8_t slot = slots.ownSlot;
+        if (slot == BeaconBatch::NO_SLOT) {
+            slot = slotForNode(_nodeId ^ checksum, slots.joinSlots);
+        }
+
+        for (uint8_t attempt = 0; attempt < ACK_MAX_ATTEMPTS && (slotCount == 0 ? attempt == 0 : slot < slotCount); ++attempt) {
+            waitUntil(beaconEndUs + slot * slotUs);
+
+            if (attempt > 0) {
+                _state->metrics.count(LinkMetrics::ACK_RETRIES);
+            }
+            AirtimeGovernor::Priority priority = attempt == 0 ? AirtimeGovernor::PRIORITY_HIGH : AirtimeGovernor::PRIORITY_LOW;
+            startAckFrame(radio, Timer::FRAME_TYPE_ACK, checksum, _nodeId, _state->radio.outputPower, priority, _ackMetrics);
+            int sendState = finishTransmitFrame(radio);
+            if (sendState == ERR_AIRTIME_EXHAUSTED) {
+                Serial.println("Client airtime budget used up, no more ACKs.");
+                break;
+            }
+            if (sendState == RADIOLIB_ERR_NONE) {
+                Serial.print("Client sent ACK in slot ");
+                Serial.println(slot);
+            } else {
+                Serial.println("Client failed to send ACK.");
+            }
+
+            unsigned long windowStart = millis();
+            while (millis() - windowStart < confirmTimeout) {
+                uint32_t remaining = confirmTimeout - (millis() - windowStart);
+                int state = receivePacket(radio, packet, remaining);
+                if (state != RADIOLIB_ERR_NONE) {
+                    continue;
+                }
+                uint16_t confirmedNode = 0;
+                uint8_t hostBattery = 0;
+                if (parseAckFrame(packet.data(), packet.getLength(), Timer::FRAME_TYPE_ACK_CONFIRM, checksum, confirmedNode, commandedPower, hostBattery) && confirmedNode == _nodeId) {
+                    _state->metrics.record(LinkMetrics::HIST_ACK_LATENCY, (int32_t)((packet.getReceivedUs() - beaconEndUs) / 1000));
+                    return ACK_CONFIRMED;
+                }
+                if (isBeacon(packet.data(), packet.getLength())) {
+                    return ACK_SUPERSEDED;
+                }
+            }
+
+            uint8_t exponent = attempt + 1 < ACK_BACKOFF_MAX_EXPONENT ? attempt + 1 : ACK_BACKOFF_MAX_EXPONENT;
+            // The confirmation wait may have run past the next slots; sending in one of them would run into the slot after it
+            uint8_t first = slot + 1;
+            int64_t startedSlots = slotUs > 0 ? (WakeScheduler::nowUs() - beaconEndUs) / slotUs + 1 : 0;
+            if (startedSlots > first) {
+                first = startedSlots < slotCount ? (uint8_t)startedSlots : slotCount;
+            }
+            slot = contentionSlot(slots, slotCount, first, (uint8_t)random(0, 1 << exponent));
+        }
+
+        // Out of slots: a host that heard nobody resends its beacon after the window
+        int64_t beaconStartUs = beaconEndUs - beaconTimeOnAirUs(radio, beaconLength);
+        int64_t resendDeadlineUs = beaconStartUs + (int64_t)(beaconPeriodMs(radio, timer, beaconLength) + ACK_TURNAROUND_MS) * 1000LL + beaconTimeOnAirUs(radio, beaconLength);
+        while (WakeScheduler::nowUs() < resendDeadlineUs) {
+            uint32_t remaining = (uint32_t)((resendDeadlineUs - WakeScheduler::nowUs() + 999) / 1000);
+            int state = receivePacket(radio, packet, remaining, true);
+            if (state == RADIOLIB_ERR_NONE && isBeacon(packet.data(), packet.getLength())) {
+                return ACK_SUPERSEDED;
+            }
+        }
+
+        return ACK_UNCONFIRMED;
+    }
+
+    /**
+     * @brief Coordinates the host operations.
+     *
+     * Each beacon is followed by a window of TDMA slots: join slots, one slot assigned to each
+     * client due this cycle and retry slots (see setContentionSlots()). The host
+     * confirms every ACK it receives in that window and ends the cycle once the window of an
+     * acknowledged beacon has passed, or as soon as every client due this cycle has
+     * acknowledged and the join slots are over. One beacon carries the per-node schedules and
+     * slot assignments of the client registry (see BeaconBatch). The beacon announces
+     * the spreading factor AdrEngine chose from the previous cycle's link margins and the next
+     * channel of the hop sequence (see ChannelPlan). A warm host with known clients stops after
+     * HOST_WARM_BEACONS unanswered beacons and keeps its schedule, so a cell whose clients are
+     * all gone does not keep the host awake. Resends stop once they would take more than the
+     * low-priority share of the airtime budget; a host whose first beacon does not fit sleeps
+     * until it would. The host's own battery stretches the cell's interval, and a client
+     * whose reported battery is low gets a longer interval of its own and less link margin
+     * (see PowerPolicy).
+     * @param timer Timer object to manage timing.
+     * @param clients Registry of the cell's clients.
+     * @param radio LoRa radio object.
+     * @param warm True if the host kept its schedule from the previous cycle.
+     * @return Sleep duration in microseconds.
+     */
+    uint64_t hostCoordinate(Timer& timer, ClientTable& clients, Radio& radio, bool warm) {
+        uint8_t data[DATA_SIZE];
+        PacketPool::Packet received;
+        unsigned long lastSendTime = 0;
+        uint32_t beaconPeriod = 0;
+        bool beaconSent = false;
+        uint8_t beaconCount = 0;
+        int64_t firstSendTimeUs = 0;
+        int64_t beaconEndUs = 0;
+        bool bounded = warm && clients.size() > 0;
+        uint8_t currentSf = _state->radio.spreadingFactor;
+        uint8_t nextSf = AdrEngine::nextSpreadingFactor(clients, currentSf, _state->baseSpreadingFactor);
+        uint8_t nextPosition = _state->channels.positionOf(_state->channels.nextChannel(clients, _state->channel, (uint32_t)time(NULL))); // Beacons carry the position in the sub-band
+        _state->powerLevel = PowerPolicy::nextLevel(_battery, _state->powerLevel);
+        uint16_t cellInterval = PowerPolicy::intervalFor(_messageInterval, _state->powerLevel);
+
+        clients.beginCycle();
+
+        while (true) {
+            if (!beaconSent || millis() - lastSendTime >= beaconPeriod) {
+                if (beaconSent && clients.ackedCount() > 0) {
+                    break; // Slot window of an acknowledged beacon is over
+                }
+                if (bounded && beaconCount >= HOST_WARM_BEACONS) {
+                    Serial.println("Host heard no client, keeping the previous schedule.");
+                    break;
+                }
+
+                time_t currentTime = time(NULL);
+                uint16_t waitTime = _waitTime;
+                uint8_t sleepState = 1;
+                uint8_t slotCount = (uint8_t)(_joinSlots + clients.dueCount() + _retrySlots);
+
+                Timer beacon(currentTime, cellInterval, waitTime, sleepState, slotCount, slotLengthFor(radio), nextSf, nextPosition);
+                size_t beaconLength = BeaconBatch::serialize(beacon, clients, _joinSlots, data);
+                uint32_t windowMs = beaconPeriodMs(radio, beacon, beaconLength);
+                if ((uint32_t)cellInterval * 1000 <= windowMs) {
+                    // The next cycle would start inside this beacon's slot window
+                    cellInterval = (uint16_t)(windowMs / 1000 + 1);
+                    Serial.print("Host message interval too short for the beacon window, using ");
+                    Serial.print(cellInterval);
+                    Serial.println(" s.");
+                    beacon = Timer(currentTime, cellInterval, waitTime, sleepState, slotCount, slotLengthFor(radio), nextSf, nextPosition);
+                    beaconLength = BeaconBatch::serialize(beacon, clients, _joinSlots, data);
+                }
+
+                // Resends repeat the first beacon, so they only get the low-priority share of the airtime
+                AirtimeGovernor::Priority priority = beaconCount == 0 ? AirtimeGovernor::PRIORITY_HIGH : AirtimeGovernor::PRIORITY_LOW;
+                int64_t sendTimeUs = WakeScheduler::nowUs();
+                if (startTransmitFrame(radio, data, beaconLength, true, priority) == ERR_AIRTIME_EXHAUSTED) {
+                    Serial.println("Host airtime budget used up, no more beacons this cycle.");
+                    break;
+                }
+                if (beaconCount > 0) {
+                    _state->metrics.count(LinkMetrics::BEACON_RESENDS);
+                }
+                timer = beacon;
+                lastSentMessage.sendTimeUs = sendTimeUs;
+                _ledFunction(20); // LED on
+
+                // Bookkeeping for the slot window overlaps with the beacon's time on air
+                beaconPeriod = windowMs;
+                lastSentMessage.checksum = BeaconBatch::readChecksum(data, beaconLength);
+                if (beaconCount == 0) {
+                    firstSendTimeUs = lastSentMessage.sendTimeUs;
+                }
+
+                int state = finishTransmitFrame(radio);
+                lastSendTime = millis();
+                beaconEndUs = WakeScheduler::nowUs();
+                _ledFunction(0); // LED off
+
+                if (state == RADIOLIB_ERR_NONE) {
+                    Serial.println("Host sent Timer object successfully.");
+                } else {
+                    Serial.println("Host failed to send Timer object.");
+                }
+
+                beaconSent = true;
+                beaconCount++;
+            }
+
+            // Once every known client answered, only a node joining in a join slot is left to hear
+            unsigned long sinceSend = millis() - lastSendTime;
+            uint32_t joinWindow = (uint32_t)_joinSlots * timer.getSlotLength() * 10;
+            bool allAcked = clients.allAcked();
+            if (allAcked && sinceSend >= joinWindow) {
+                break; // No need to wait out the window
+            }
+
+            // Sleep in the receive call until the slot window ends
+            uint32_t windowEnd = allAcked ? joinWindow : beaconPeriod;
+            uint32_t timeout = sinceSend < windowEnd ? windowEnd - sinceSend : 0;
+            uint16_t nodeId = 0;
+            int8_t ackPower = 0;
+            uint8_t battery = PowerPolicy::BATTERY_UNKNOWN;
+            const uint8_t* summary = NULL;
+            int64_t listenStartUs = esp_timer_get_time();
+            int state = receivePacket(radio, received, timeout);
+            _state->trace.recordSince(CycleTrace::PHASE_ACK, listenStartUs);
+            if (state == RADIOLIB_ERR_NONE && parseAckFrame(received.data(), received.getLength(), Timer::FRAME_TYPE_ACK, lastSentMessage.checksum, nodeId, ackPower, battery, &summary)) {
+                _state->metrics.count(LinkMetrics::ACKS_RECEIVED);
+                _state->metrics.record(LinkMetrics::HIST_ACK_LATENCY, (int32_t)((received.getReceivedUs() - beaconEndUs) / 1000));
+                float snr = received.getSnr();
+                int8_t commandedPower = ackPower;
+                ClientTable::Entry* entry = clients.markAcked(nodeId, lastSentMessage.checksum, timer.getMessageInterval());
+                if (entry != NULL) {
+                    // A draining client sends with less margin and wakes for fewer of the cell's cycles
+                    PowerPolicy::recordBattery(*entry, battery);
+                    AdrEngine::recordAck(*entry, snr, currentSf, ackPower, _state->maxOutputPower, PowerPolicy::marginReliefDb(entry->powerLevel));
+                    commandedPower = entry->txPower;
+                    uint16_t clientInterval = PowerPolicy::clientIntervalFor(timer.getMessageInterval(), _state->powerLevel, entry->powerLevel);
+                    clients.setSchedule(nodeId, clientInterval > timer.getMessageInterval() ? clientInterval : 0, (uint8_t)timer.getWaitTime(), timer.getSleepState());
+                }
+                startAckFrame(radio, Timer::FRAME_TYPE_ACK_CONFIRM, lastSentMessage.checksum, nodeId, commandedPower, AirtimeGovernor::PRIORITY_HIGH);
+
+                // Logging overlaps with the confirmation's time on air
+                if (entry == NULL) {
+                    Serial.println("Host client table is full.");
+                }
+                Serial.print("Host received ACK from node ");
+                Serial.print((unsigned int)nodeId, HEX);
+                Serial.println(".");
+                if (summary != NULL) {
+                    LinkMetrics::printSummary(Serial, nodeId, summary);
+                }
+
+                if (finishTransmitFrame(radio) != RADIOLIB_ERR_NONE) {
+                    Serial.println("Host failed to send confirmation.");
+                }
+            }
+        }
+
+        if (!beaconSent) {
+            // Not even the first beacon fitted: keep the schedule and the clients, and skip
+            // cycles until the budget has room for it again
+            int64_t waitUs = _txWaitUs < AirtimeGovernor::WINDOW_US ? _txWaitUs : AirtimeGovernor::WINDOW_US;
+            uint64_t sleepDuration = _scheduler->scheduleWake(0);
+            return sleepDuration > (uint64_t)waitUs ? sleepDuration : (uint64_t)waitUs;
+        }
+
+        clients.endCycle();
+        int64_t timeSinceSentUs = WakeScheduler::nowUs() - lastSentMessage.sendTimeUs;
+
+        // The acknowledged beacon is the host's reference point for the next cycle; without
+        // an ACK the first beacon is, which is where warm clients expect the next one
+        int64_t anchorUs = clients.ackedCount() > 0 ? lastSentMessage.sendTimeUs : firstSendTimeUs;
+        _scheduler->synchronize(anchorUs, (int64_t)timer.getMessageInterval() * 1000000LL, false);
+        uint64_t sleepDuration = _scheduler->scheduleWake(0);
+
+        Serial.print("Host cycle done with ");
+        Serial.print(clients.ackedCount());
+        Serial.print(" of ");
+        Serial.print(clients.size());
+        Serial.print(" clients. Time since sent: ");
+        Serial.print((unsigned long)(timeSinceSentUs / 1000));
+        Serial.print(" ms. Sleeping for: ");
+        Serial.print((unsigned long)(sleepDuration / 1000));
+        Serial.println(" ms.");
+
+        return sleepDuration;
+    }
+
+    /**
+     * @brief Coordinates the client operations.
+     *
+     * A warm client only listens from its wake until one beacon time-on-air and a guard time
+     * after the expected sync. Missing that window sends it back to sleep for the next cycle;
+     * after CoordinationState::MAX_MISSED_WARM_WINDOWS misses in a row it falls back to
+     * listening until any beacon arrives. Beacons are awaited in the RX duty-cycle mode, so the
+     * receiver sleeps between preamble checks however late the host is.
+     * @param timer Timer object to manage timing.
+     * @param radio LoRa radio object.
+     * @param warm True if the client kept its schedule from the previous cycle.
+     * @return Sleep duration in microseconds.
+     */
+    uint64_t clientCoordinate(Timer& timer, Radio& radio, bool warm) {
+        PacketPool::Packet received;
+        bool pending = false; // True when the ACK exchange left a newer Timer in received
+        int64_t deadlineUs = 0; // End of the warm listen window, 0 while discovering
+
+        if (warm && _scheduler->getExpectedSyncUs() != 0) {
+            deadlineUs = _scheduler->getExpectedSyncUs() + beaconTimeOnAirUs(radio, DATA_SIZE) + CLIENT_GUARD_US;
+        }
+
+        while (true) {
+            int state = RADIOLIB_ERR_NONE;
+            if (!pending) {
+                uint32_t timeout = WAIT_FOREVER;
+                if (deadlineUs != 0) {
+                    int64_t remaining = deadlineUs - WakeScheduler::nowUs();
+                    if (remaining <= 0) {
+                        _state->metrics.count(LinkMetrics::BEACONS_MISSED);
+                        if (++_state->missedWarmWindows < CoordinationState::MAX_MISSED_WARM_WINDOWS) {
+                            Serial.println("Client missed the beacon, sleeping until the next cycle.");
+                            return _scheduler->scheduleWake(CLIENT_GUARD_US);
+                        }
+                        Serial.println("Client lost the schedule, falling back to discovery.");
+                        deadlineUs = 0;
+                        continue;
+                    }
+                    timeout = (uint32_t)((remaining + 999) / 1000);
+                }
+                int64_t listenStartUs = esp_timer_get_time();
+                state = receivePacket(radio, received, timeout, true);
+                _state->trace.recordSince(CycleTrace::PHASE_BEACON_WAIT, listenStartUs);
+                if (state == RADIOLIB_ERR_RX_TIMEOUT) {
+                    continue;
+                }
+            }
+            pending = false;
+
+            if (state == RADIOLIB_ERR_NONE) {
+                // The packet ended at reception, so the beacon started one time-on-air earlier
+                size_t beaconLength = received.getLength();
+                int64_t beaconEndUs = received.getReceivedUs();
+                int64_t syncUs = beaconEndUs - beaconTimeOnAirUs(radio, beaconLength);
+                Serial.println("Client received data.");
+
+                Timer receivedTimer(0, 0, 0, 0);
+                BeaconBatch::SlotPlan slots;
+                bool valid = BeaconBatch::deserialize(received.data(), beaconLength, _nodeId, receivedTimer, slots);
+
+                if (valid) {
+                    uint16_t receivedChecksum = BeaconBatch::readChecksum(received.data(), beaconLength);
+                    uint16_t calculatedChecksum = Timer::calculateChecksum(received.data(), beaconLength - 2);
+
+                    char line1[DISPLAY_LINE_SIZE];
+                    char line2[DISPLAY_LINE_SIZE];
+                    snprintf(line1, sizeof(line1), "Msg Interval: %u sec", (unsigned int)receivedTimer.getMessageInterval());
+                    _displayFunction("Received Timer:", line1);
+                    snprintf(line1, sizeof(line1), "Checksum: %x", (unsigned int)receivedChecksum);
+                    snprintf(line2, sizeof(line2), "Calculated: %x", (unsigned int)calculatedChecksum);
+                    _displayFunction(line1, line2);
+
+                    if (deadlineUs != 0) {
+                        int64_t syncErrorUs = syncUs - _scheduler->getExpectedSyncUs();
+                        _state->metrics.record(LinkMetrics::HIST_SYNC_ERROR, (int32_t)((syncErrorUs < 0 ? -syncErrorUs : syncErrorUs) / 1000));
+                    }
+                    timer = receivedTimer;
+                    _state->metrics.recordBeacon(received.getRssi(), received.getSnr()); // Downlink sent in the ACK summary
+                    _state->missedWarmWindows = 0;
+                    _scheduler->synchronize(syncUs, (int64_t)timer.getMessageInterval() * 1000000LL, true);
+
+                    Serial.println("Client received valid Timer object.");
+
+                    int8_t commandedPower = 0;
+                    int64_t ackStartUs = esp_timer_get_time();
+                    AckResult result = acknowledge(radio, timer, slots, receivedChecksum, beaconEndUs, beaconLength, received, commandedPower);
+                    _state->trace.recordSince(CycleTrace::PHASE_ACK, ackStartUs);
+                    if (result == ACK_SUPERSEDED) {
+                        Serial.println("Client received a newer Timer while waiting for confirmation.");
+                        pending = true;
+                        continue;
+                    }
+                    if (result == ACK_CONFIRMED) {
+                        applyOutputPower(radio, commandedPower);
+                    } else {
+                        _state->metrics.count(LinkMetrics::ACKS_UNCONFIRMED);
+                        Serial.println("Client got no ACK confirmation, keeping the received schedule.");
+                        applyOutputPower(radio, AdrEngine::unconfirmedPower(_state->radio.outputPower, _state->maxOutputPower));
+                    }
+
+                    uint64_t meetingInterval = _scheduler->scheduleWake(CLIENT_GUARD_US);
+
+                    Serial.print("Client going to sleep for ");
+                    Serial.print((unsigned long)(meetingInterval / 1000));
+                    Serial.print(" ms. Drift: ");
+                    Serial.print((long)_scheduler->getDriftPpm());
+                    Serial.println(" ppm.");
+                    return meetingInterval;
+                } else {
+                    if (isBeacon(received.data(), beaconLength)) {
+                        _state->metrics.count(LinkMetrics::CHECKSUM_ERRORS); // Other clients' ACKs are not beacon errors
+                    }
+                    Serial.println("Received data checksum mismatch.");
+                }
+            } else {
+                Serial.println("Client did not receive data.");
+            }
+        }
+    }
+};
+
+template <class Radio>
+TaskHandle_t BasicWakeUpCoordination<Radio>::_receiveTask = NULL;
+
+typedef BasicWakeUpCoordination<SX1262> WakeUpCoordination; // Coordinator for RadioLib's SX1262
+
+#endif // WAKE_UP_COORDINATION_H
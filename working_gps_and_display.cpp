@@ -1,17 +1,13 @@
 #define HELTEC_POWER_BUTTON
 #include <heltec_unofficial.h>
-#include <TinyGPSPlus.h>
-#include <HardwareSerial.h>
+#include "GpsTask.h" // Includes the GPS task from the LoRaCoordination library, see install_library.sh
 
 // Define GPS pins
 #define GPS_RX_PIN 45
 #define GPS_TX_PIN 46
 
-// Create a TinyGPSPlus object
-TinyGPSPlus gps;
-
-// Use Serial2 for the GPS
-HardwareSerial gpsSerial(2);
+// Read the GPS on UART2 from its own task on core 0
+GpsTask gpsTask(UART_NUM_2, GPS_RX_PIN, GPS_TX_PIN, 9600);
 
 unsigned long startMillis;
 
@@ -19,8 +15,10 @@ void setup() {
   // Initialize the serial communication with the computer
   Serial.begin(115200);
 
-  // Initialize the serial communication with the GPS module
-  gpsSerial.begin(9600, SERIAL_8N1, GPS_RX_PIN, GPS_TX_PIN);
+  // Start the GPS task
+  if (!gpsTask.begin(0)) {
+    Serial.println(F("GPS task failed to start."));
+  }
 
   // Initialize the Heltec display
   heltec_setup();
@@ -31,14 +29,13 @@ void setup() {
 }
 
 void loop() {
-  // Check if data is available from the GPS module
-  while (gpsSerial.available() > 0) {
-    if (gps.encode(gpsSerial.read())) {
-      displayInfo();
-    }
+  // Take the latest fix published by the GPS task
+  GpsSnapshot fix = GpsSnapshot();
+  if (gpsTask.read(fix)) {
+    displayInfo(fix);
   }
 
-  if (millis() - startMillis > 5000 && gps.charsProcessed() < 10) {
+  if (millis() - startMillis > 5000 && fix.charsProcessed < 10) {
     display.clear();
     display.drawString(0, 0, "No GPS detected: check wiring.");
     display.display();
@@ -49,21 +46,19 @@ void loop() {
   delay(1000); // Update every second
 }
 
-void displayInfo() {
+void displayInfo(const GpsSnapshot& fix) {
   display.clear();
   Serial.print(F("Location: "));
 
-  if (gps.location.isValid()) {
-    String lat = String(gps.location.lat(), 6);
-    String lng = String(gps.location.lng(), 6);
-
-    display.drawString(0, 0, "Lat: " + lat);
-    display.drawString(0, 10, "Lng: " + lng);
+  if (fix.locationValid) {
+    char line[24];
+    snprintf(line, sizeof(line), "Lat: %.6f", fix.lat);
+    display.drawString(0, 0, line);
+    snprintf(line, sizeof(line), "Lng: %.6f", fix.lng);
+    display.drawString(0, 10, line);
     display.drawString(0, 20, "Fix: Valid");
 
-    Serial.print(lat);
-    Serial.print(F(", "));
-    Serial.println(lng);
+    Serial.printf("%.6f, %.6f\n", fix.lat, fix.lng);
   } else if (millis() - startMillis < 120000) { // Within the first 2 minutes
     display.drawString(0, 0, "Searching for satellites...");
     display.drawString(0, 10, "Please wait...");
@@ -78,12 +73,11 @@ void displayInfo() {
   }
 
   // Display altitude if available
-  if (gps.altitude.isValid()) {
-    String alt = String(gps.altitude.meters());
-    display.drawString(0, 30, "Alt: " + alt + " m");
-    Serial.print(F("Altitude: "));
-    Serial.print(alt);
-    Serial.println(F(" m"));
+  if (fix.altitudeValid) {
+    char line[24];
+    snprintf(line, sizeof(line), "Alt: %.2f m", fix.altitudeMeters);
+    display.drawString(0, 30, line);
+    Serial.printf("Altitude: %.2f m\n", fix.altitudeMeters);
   } else {
     display.drawString(0, 30, "Alt: INVALID");
     Serial.println(F("Altitude: INVALID"));
@@ -96,9 +90,8 @@ void displayInfo() {
 void updateSerial(){
   delay(500);
   while (Serial.available()) {
-    gpsSerial.write(Serial.read()); // Forward what Serial received to Serial2
-  }
-  while (gpsSerial.available()) {
-    Serial.write(gpsSerial.read()); // Forward what Serial2 received to Serial
+    uint8_t c = Serial.read();
+    gpsTask.write(&c, 1); // Forward what Serial received to the GPS module
   }
+  // The GPS task owns the receive side, its output is only available through the snapshot
 }